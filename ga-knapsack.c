@@ -5,9 +5,9 @@
 #include <string.h>
 #include <errno.h>
 #include <stdio.h>
-#include <ctype.h>
 #include <math.h>
 #include <time.h>
+#include "knapsack-instance.h"
 
 /* CONSTANTS ------------------------- */
 
@@ -30,10 +30,8 @@ struct gak_item
 {
     int cost;
     int value;
-    char* label;
+    const char* label; /* points into the loaded instance data */
 };
-struct gak_item* gak_item_new(int cost,int value,const char* label);
-void gak_item_free(struct gak_item* item);
 
 /* represent a candidate solution */
 struct gak_candidate
@@ -78,15 +76,19 @@ struct gak_instance
 {
     int costLimit;
 
-    size_t itemSz, itemCap;
+    size_t itemSz;
     struct gak_item** items;
+    struct gak_item* itemPool;
+
+    /* the loaded instance file; this owns the item labels */
+    struct kinst* source;
 
     size_t bitcnt;
     size_t bytecnt;
 
     bool nonZeroSol;
 };
-struct gak_instance* gak_instance_new(FILE* fin,const char* filename);
+struct gak_instance* gak_instance_new(const char* path,const char* filename);
 void gak_instance_free(struct gak_instance* inst);
 void gak_instance_apply_metrics(struct gak_instance* inst,struct gak_candidate* cand); /* apply fitness, sum value and sum cost to candidate */
 
@@ -99,8 +101,6 @@ static void crossover_alternate(const uint8_t* bitsParentA,const uint8_t* bitsPa
 
 static void gak_error(bool useErrno,const char* format, ...);
 static void gak_fatal_error(bool useErrno,const char* format, ...);
-static int readline(FILE* fin,char* buf,size_t cap);
-static char* commasep(char** s);
 static int gak_candidate_compar_byfitness(const struct gak_candidate** left,const struct gak_candidate** right);
 static void zero_last_bits(uint8_t* byte,size_t lastBits);
 
@@ -110,7 +110,7 @@ static const char* programName;
 
 /* MAIN FUNCTIONS -------------------- */
 
-static void ga_knapsack(FILE* file,const char* filename);
+static void ga_knapsack(const char* path,const char* filename);
 
 int main(int argc,const char* argv[])
 {
@@ -120,19 +120,11 @@ int main(int argc,const char* argv[])
     /* process command-line arguments */
     if (argc > 1) {
         int i;
-        for (i = 1;i < argc;++i) {
-            FILE* fin;
-            fin = fopen(argv[i],"r");
-            if (fin == NULL)
-                gak_error(true,"cannot open '%s'",argv[i]);
-            else {
-                ga_knapsack(fin,argv[i]);
-                fclose(fin);
-            }
-        }
+        for (i = 1;i < argc;++i)
+            ga_knapsack(argv[i],argv[i]);
     }
     else
-        ga_knapsack(stdin,"stdin");
+        ga_knapsack(NULL,"stdin");
     return 0;
 }
 
@@ -145,27 +137,6 @@ static inline int min(int a,int b)
 
 /* IMPLEMENTATION -------------------- */
 
-/* gak_item */
-struct gak_item* gak_item_new(int cost,int value,const char* label)
-{
-    struct gak_item* item;
-    item = malloc(sizeof(struct gak_item));
-    if (item == NULL)
-        gak_fatal_error(false,"memory allocation failure");
-    item->cost = cost;
-    item->value = value;
-    item->label = malloc(strlen(label)+1);
-    if (item->label == NULL)
-        gak_fatal_error(false,"memory allocation failure");
-    strcpy(item->label,label);
-    return item;
-}
-void gak_item_free(struct gak_item* item)
-{
-    free(item->label);
-    free(item);
-}
-
 /* gak_candidate */
 struct gak_candidate* gak_candidate_new_random(struct gak_instance* inst)
 {
@@ -431,69 +402,44 @@ void gak_population_print(struct gak_population* popl,struct gak_instance* inst)
 }
 
 /* gak_instance */
-struct gak_instance* gak_instance_new(FILE* fin,const char* filename)
+struct gak_instance* gak_instance_new(const char* path,const char* filename)
 {
+    size_t iter;
+    char err[512];
+    struct kinst* source;
     struct gak_instance* inst;
-    char linebuf[4097];
-    inst = malloc(sizeof(struct gak_instance));
-    if (inst == NULL)
-        gak_fatal_error(false,"memory allocation failure");
-    /* read in knapsack cost limit */
-    readline(fin,linebuf,sizeof(linebuf));
-    if (sscanf(linebuf,"%d",&inst->costLimit) != 1) {
-        gak_error(false,"format error in file '%s': expected numeric cost limit",filename);
-        free(inst);
+    /* load the instance file; the item labels are not copied out of it */
+    source = kinst_load(path,filename,err,sizeof(err));
+    if (source == NULL) {
+        gak_error(false,"%s",err);
         return NULL;
     }
-    /* read items */
-    inst->itemSz = 0;
-    inst->itemCap = 8;
-    inst->items = malloc(sizeof(struct gak_item*) * inst->itemCap);
-    inst->nonZeroSol = false; /* is there at least one item that can fit in a sack? */
-    if (inst->items == NULL)
-        gak_fatal_error(false,"memory allocation failure");
-    while (true) {
-        /* check reallocation on dynamic array */
-        if (inst->itemSz >= inst->itemCap) {
-            size_t cap;
-            struct gak_item** block;
-            cap = inst->itemCap << 1;
-            block = realloc(inst->items,sizeof(struct gak_item*) * cap);
-            if (block == NULL)
-                gak_fatal_error(false,"memory allocation failure");
-            inst->items = block;
-            inst->itemCap = cap;
-        }
-        /* read item line input */
-        if ( readline(fin,linebuf,sizeof(linebuf)) ) {
-            char* s, *name;
-            int cost, value;
-            s = linebuf;
-            name = commasep(&s);
-            if (sscanf(commasep(&s),"%d",&cost) != 1) {
-                gak_error(false,"format error in file '%s': expected integer value for item cost",filename);
-                gak_instance_free(inst);
-                return NULL;
-            }
-            if (sscanf(commasep(&s),"%d",&value) != 1) {
-                gak_error(false,"format error in file '%s': expected integer value for item value",filename);
-                gak_instance_free(inst);
-                return NULL;
-            }
-            if (cost < inst->costLimit)
-                inst->nonZeroSol = true;
-            inst->items[inst->itemSz++] = gak_item_new(cost,value,name);
-        }
-        else {
-            inst->items[inst->itemSz] = NULL;
-            break;
-        }
-    }
-    if (inst->itemSz == 0) {
+    if (source->count == 0) {
         gak_error(false,"file '%s' has an empty item set",filename);
-        gak_instance_free(inst);
+        kinst_free(source);
         return NULL;
     }
+    inst = malloc(sizeof(struct gak_instance));
+    if (inst == NULL)
+        gak_fatal_error(false,"memory allocation failure");
+    inst->source = source;
+    inst->costLimit = source->limit;
+    inst->itemSz = source->count;
+    inst->itemPool = malloc(sizeof(struct gak_item) * inst->itemSz);
+    inst->items = malloc(sizeof(struct gak_item*) * (inst->itemSz+1));
+    if (inst->itemPool==NULL || inst->items==NULL)
+        gak_fatal_error(false,"memory allocation failure");
+    inst->nonZeroSol = false; /* is there at least one item that can fit in a sack? */
+    for (iter = 0;iter < inst->itemSz;++iter) {
+        struct gak_item* item = inst->itemPool + iter;
+        item->cost = source->cost[iter];
+        item->value = source->value[iter];
+        item->label = source->names[iter];
+        if (item->cost < inst->costLimit)
+            inst->nonZeroSol = true;
+        inst->items[iter] = item;
+    }
+    inst->items[inst->itemSz] = NULL;
     /* compute the number of bytes needed to represent
        the candidates' item bitstring */
     inst->bytecnt = inst->itemSz/8;
@@ -503,10 +449,9 @@ struct gak_instance* gak_instance_new(FILE* fin,const char* filename)
 }
 void gak_instance_free(struct gak_instance* inst)
 {
-    size_t iter;
-    for (iter = 0;iter < inst->itemSz;++iter)
-        gak_item_free(inst->items[iter]);
     free(inst->items);
+    free(inst->itemPool);
+    kinst_free(inst->source);
     free(inst);
 }
 void gak_instance_apply_metrics(struct gak_instance* inst,struct gak_candidate* cand)
@@ -560,38 +505,6 @@ void gak_fatal_error(bool useErrno,const char* format, ...)
     va_end(vargs);
     exit(1);
 }
-int readline(FILE* fin,char* buf,size_t cap)
-{
-    size_t s = --cap;
-    while (cap > 0) {
-        size_t len;
-        if (fgets(buf,cap+1,fin) == NULL)
-            return feof(fin) && cap<s;
-        len = strlen(buf);
-        if (buf[len-1] == '\n') {
-            buf[len-1] = 0;
-            break;
-        }
-        buf += len;
-        cap -= len;
-    }
-    return 1;
-}
-char* commasep(char** s)
-{
-    char* i, *start;
-    while ( isspace(**s) )
-        ++*s;
-    start = *s;
-    while (**s && **s!=',')
-        ++*s;
-    i = *s-1;
-    while ( isspace(*i) )
-        *(i--) = 0;
-    **s = 0;
-    ++*s;
-    return start;
-}
 int gak_candidate_compar_byfitness(const struct gak_candidate** left,const struct gak_candidate** right)
 {
     return (*right)->fitness - (*left)->fitness;
@@ -673,7 +586,7 @@ void crossover_alternate(const uint8_t* bitsParentA,const uint8_t* bitsParentB,u
 
 
 /* main program operation */
-void ga_knapsack(FILE* fin,const char* filename)
+void ga_knapsack(const char* path,const char* filename)
 {
     static crossover_func crossoverFunctions[] = {crossover_alternate,crossover_random};
     int fit;
@@ -681,7 +594,7 @@ void ga_knapsack(FILE* fin,const char* filename)
     size_t totalCycles, totalMutations;
     struct gak_instance* inst;
     struct gak_population* popl;
-    inst = gak_instance_new(fin,filename);
+    inst = gak_instance_new(path,filename);
     if (inst == NULL)
         /* instance could not be initialized */
         return;
@@ -718,6 +631,7 @@ void ga_knapsack(FILE* fin,const char* filename)
     } while (cnt > 0);
     gak_candidate_print(popl->members[0],inst);
     printf("[total cycles]   %*zu\n[total mutations]%*zu\n",6,totalCycles,6,totalMutations);
+    printf("[parse MB/s]     %*.1f\n",6,kinst_throughput(inst->source));
     gak_population_free(popl);
     gak_instance_free(inst);
 }
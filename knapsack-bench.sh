@@ -0,0 +1,180 @@
+#!/bin/sh
+# knapsack-bench.sh - benchmark the knapsack2 algorithms; every algorithm is run
+# several times over instances/ and over instance classes generated by
+# knapsack-gen, and the median times are compared against a baseline file;
+# only needs sh and awk
+#
+# usage: knapsack-bench.sh [-k knapsack] [-g knapsack-gen] [-r repeats]
+#                          [-s sizes] [-b baseline] [-t threshold]
+#                          [-l seconds] [-w]
+#   -k  knapsack binary (default ./knapsack)
+#   -g  knapsack-gen binary (default ./knapsack-gen)
+#   -r  runs of each algorithm on each instance (default 5)
+#   -s  sizes of the generated instances (default "50 200 1000")
+#   -b  baseline file (default knapsack-bench.baseline)
+#   -t  percent slowdown of the median time flagged as a regression (default 10)
+#   -l  --time-limit for the branch and bound searches (default 5); runs that
+#       hit it are compared by node throughput instead of time
+#   -w  write the results to the baseline file instead of comparing
+# the exit status is 1 if any regression was flagged
+
+KNAPSACK=./knapsack
+GEN=./knapsack-gen
+REPEATS=5
+SIZES="50 200 1000"
+BASELINE=knapsack-bench.baseline
+THRESHOLD=10
+WRITE=0
+TIMELIMIT=5
+MINTIME=0.001 # medians faster than this (seconds) are too noisy to compare
+
+while getopts k:g:r:s:b:t:l:w opt; do
+    case $opt in
+    k) KNAPSACK=$OPTARG ;;
+    g) GEN=$OPTARG ;;
+    r) REPEATS=$OPTARG ;;
+    s) SIZES=$OPTARG ;;
+    b) BASELINE=$OPTARG ;;
+    t) THRESHOLD=$OPTARG ;;
+    l) TIMELIMIT=$OPTARG ;;
+    w) WRITE=1 ;;
+    *) sed -n '7,18s/^# \{0,1\}//p' "$0" >&2; exit 2 ;;
+    esac
+done
+for prog in "$KNAPSACK" "$GEN"; do
+    if [ ! -x "$prog" ]; then
+        echo "$0: cannot run '$prog'; build it first" >&2
+        exit 2
+    fi
+done
+if command -v timeout >/dev/null 2>&1; then
+    TIMEOUT="timeout 60"
+else
+    TIMEOUT=
+fi
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/knapsack-bench.XXXXXX") || exit 2
+trap 'rm -rf "$WORK"' EXIT INT TERM
+
+# generate an instance: class size seed; the costs are drawn from [1,1000] and
+# the cost limit is half the total cost (knapsack-gen's defaults)
+generate() {
+    "$GEN" --class="$1" --seed="$3" "$2"
+}
+
+# pick the algorithms worth running on an instance: the exponential searches
+# only on small instances and the DP only when its table is small enough
+algorithms() {
+    awk -F, 'NR == 1 { limit = $1 } NR > 1 { ++n } END {
+        list = "optimized,parallel,best-first,fptas"
+        if (n <= 30)
+            list = list ",optimized1,optimized2,bruteforce"
+        if (n <= 40)
+            list = list ",mitm"
+        if (n * (limit+1) <= 200000000)
+            list = list ",dp"
+        print list
+    }' "$1"
+}
+
+INSTANCES=
+for f in instances/*.csv; do
+    [ -f "$f" ] && INSTANCES="$INSTANCES $f"
+done
+for class in uncorrelated weak strong subset-sum; do
+    for n in $SIZES; do
+        f="$WORK/$class-$n.csv"
+        generate $class $n $n > "$f"
+        INSTANCES="$INSTANCES $f"
+    done
+done
+
+# run everything; each run appends its --stats=csv records to runs.csv
+: > "$WORK/runs.csv"
+for f in $INSTANCES; do
+    for alg in $(algorithms "$f" | tr , ' '); do
+        i=0
+        while [ $i -lt "$REPEATS" ]; do
+            if ! $TIMEOUT "$KNAPSACK" --stats=csv --time-limit=$TIMELIMIT -a $alg "$f" > "$WORK/run.csv" 2>/dev/null; then
+                echo "$0: $alg failed or timed out on $f" >&2
+                break
+            fi
+            sed 1d "$WORK/run.csv" | sed "s|$WORK/||" >> "$WORK/runs.csv"
+            i=$((i+1))
+        done
+    done
+done
+
+# summarize: sort each instance/algorithm group by wall time, then take the
+# median and the 10th/90th percentiles (nearest rank); the node rate is that
+# of the median run; a group is optimal only if none of its runs was stopped by
+# the time limit
+sort -t, -k1,1 -k2,2 -k9,9g "$WORK/runs.csv" | awk -F, '
+    function flush() {
+        if (cnt == 0)
+            return
+        p10 = wall[int(0.1*cnt + 0.999999)]
+        mid = int(0.5*cnt + 0.999999)
+        p50 = wall[mid]
+        p90 = wall[int(0.9*cnt + 0.999999)]
+        printf "%s,%s,%d,%.6f,%.6f,%.6f,%.0f,%d\n", file, alg, cnt, p50, p10, p90, (p50 > 0 ? nodes[mid]/p50 : 0), optimal
+        cnt = 0
+        optimal = 1
+    }
+    { gsub(/"/, "", $1); gsub(/"/, "", $2) }
+    $1 != file || $2 != alg { flush(); file = $1; alg = $2; optimal = 1 }
+    { wall[++cnt] = $9; nodes[cnt] = $11; if ($8 == 0) optimal = 0 }
+    END { flush() }' > "$WORK/summary.csv"
+
+if [ $WRITE -eq 1 ]; then
+    {
+        echo "instance,algorithm,runs,median_sec,p10_sec,p90_sec,nodes_per_sec,optimal"
+        cat "$WORK/summary.csv"
+    } > "$BASELINE"
+    echo "wrote baseline '$BASELINE' ($(wc -l < "$WORK/summary.csv") results)"
+    exit 0
+fi
+
+if [ -f "$BASELINE" ]; then
+    BASE="$BASELINE"
+else
+    echo "no baseline '$BASELINE'; run with -w (or 'make bench-baseline') to record one"
+    BASE=/dev/null
+fi
+awk -F, -v threshold="$THRESHOLD" -v mintime="$MINTIME" '
+    # the baseline may be /dev/null, so tell the files apart by name
+    FILENAME == ARGV[1] { if (FNR > 1) { base[$1 "," $2] = $4; baseRate[$1 "," $2] = $7 } next }
+    FNR == 1 {
+        printf "%-28s %-11s %4s %11s %11s %11s %13s %8s\n", "instance", "algorithm", "runs",
+            "median(s)", "p10(s)", "p90(s)", "nodes/sec", "change"
+    }
+    {
+        key = $1 "," $2
+        change = ""
+        if (!$8 && baseRate[key] > 0) {
+            # stopped runs take the same time: compare the node rate
+            pct = 100 * (baseRate[key] - $7) / baseRate[key]
+            change = sprintf("%+.1f%% rate", -pct)
+            if (pct > threshold) {
+                change = change " REGRESSION"
+                ++regressions
+            }
+        }
+        else if (base[key] > 0) {
+            # finished runs, and the fptas, which visits no nodes and is not
+            # optimal, are compared by time
+            pct = 100 * ($4 - base[key]) / base[key]
+            change = sprintf("%+.1f%%", pct)
+            if (pct > threshold && ($4 >= mintime || base[key] >= mintime)) {
+                change = change " REGRESSION"
+                ++regressions
+            }
+        }
+        printf "%-28s %-11s %4d %11.6f %11.6f %11.6f %13.0f %s\n", $1, $2, $3, $4, $5, $6, $7, change
+    }
+    END {
+        if (regressions > 0) {
+            printf "%d regression(s) over %s%%\n", regressions, threshold
+            exit 1
+        }
+    }' "$BASE" "$WORK/summary.csv"
@@ -0,0 +1,85 @@
+/* knapsack-convert.c - convert knapsack problem instances between the CSV
+   format and the binary format */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include "knapsack-instance.h"
+
+static const char* programName;
+static void usage()
+{
+    fprintf(stderr,"usage: %s [--csv] [--wide] [--no-names] input output\n",programName);
+    fprintf(stderr,"  input may be CSV or binary; '-' names stdin or stdout\n");
+    fprintf(stderr,"  --csv       write CSV instead of the binary format\n");
+    fprintf(stderr,"  --wide      write 64-bit cost and value arrays\n");
+    fprintf(stderr,"  --no-names  leave out the item names (binary only)\n");
+    exit(EXIT_FAILURE);
+}
+static int write_csv(const struct kinst* inst,FILE* out)
+{
+    size_t i;
+    fprintf(out,"%d\n",inst->limit);
+    for (i = 0;i < inst->count;++i)
+        fprintf(out,"%s,%d,%d\n",inst->names[i],inst->cost[i],inst->value[i]);
+    return fflush(out) == 0;
+}
+int main(int argc,char* argv[])
+{
+    int opt, csv, ok;
+    unsigned flags;
+    char err[512];
+    const char* input, *output;
+    FILE* fout;
+    struct kinst* inst;
+    static const struct option longOptions[] = {
+        {"csv", no_argument, NULL, 'c'},
+        {"wide", no_argument, NULL, 'w'},
+        {"no-names", no_argument, NULL, 'n'},
+        {NULL, 0, NULL, 0}
+    };
+    programName = argv[0];
+    csv = 0;
+    flags = KINST_NAMES;
+    while ((opt = getopt_long(argc,argv,"",longOptions,NULL)) != -1) {
+        switch (opt) {
+        case 'c':
+            csv = 1;
+            break;
+        case 'w':
+            flags |= KINST_WIDE;
+            break;
+        case 'n':
+            flags &= ~KINST_NAMES;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (argc-optind != 2)
+        usage();
+    input = argv[optind];
+    output = argv[optind+1];
+    inst = kinst_load(strcmp(input,"-")==0 ? NULL : input,strcmp(input,"-")==0 ? "stdin" : input,err,sizeof(err));
+    if (inst == NULL) {
+        fprintf(stderr,"%s: %s\n",programName,err);
+        return EXIT_FAILURE;
+    }
+    if (strcmp(output,"-") == 0)
+        fout = stdout;
+    else if ((fout = fopen(output,"wb")) == NULL) {
+        fprintf(stderr,"%s: cannot open '%s': %s\n",programName,output,strerror(errno));
+        kinst_free(inst);
+        return EXIT_FAILURE;
+    }
+    ok = csv ? write_csv(inst,fout) : kinst_write_binary(inst,fout,flags);
+    if (!ok)
+        fprintf(stderr,"%s: cannot write '%s': %s\n",programName,output,strerror(errno));
+    if (fout!=stdout && fclose(fout)!=0 && ok) {
+        fprintf(stderr,"%s: cannot write '%s': %s\n",programName,output,strerror(errno));
+        ok = 0;
+    }
+    kinst_free(inst);
+    return ok ? 0 : EXIT_FAILURE;
+}
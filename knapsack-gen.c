@@ -0,0 +1,294 @@
+/* knapsack-gen.c - generate knapsack problem instances of the standard
+   hardness classes in the CSV or binary format */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include "knapsack-instance.h"
+
+enum kgen_class
+{
+    KGEN_UNCORRELATED, /* cost and value independent in [1,R] */
+    KGEN_WEAK, /* value within R/10 of the cost */
+    KGEN_STRONG, /* value = cost + R/10 */
+    KGEN_INVERSE, /* cost = value + R/10 */
+    KGEN_SUBSET_SUM /* value = cost */
+};
+
+static const char* const classNames[] = {
+    "uncorrelated", "weak", "strong", "inverse", "subset-sum"
+};
+
+enum kgen_constants
+{
+    KGEN_MAX_RANGE = 100000000, /* keeps cost and value + R/10 in an int */
+    KGEN_BUFFER_SIZE = 1 << 20,
+    KGEN_MAX_LINE = 48 /* longest CSV line: a 20 digit number and two ints */
+};
+
+static const char* programName;
+static void usage();
+static int parse_unsigned(const char* arg,unsigned long long max,unsigned long long* result);
+static uint64_t rng_next(uint64_t* state);
+static int rng_range(uint64_t* state,int lo,int hi);
+static void generate(struct kinst* inst,int class,int range,uint64_t seed);
+static char* put_uint(char* p,unsigned long v);
+static int write_csv(const struct kinst* inst,FILE* out);
+
+int main(int argc,char* argv[])
+{
+    int opt, class, range, binary, ok;
+    unsigned flags;
+    long long limit;
+    unsigned long long n;
+    uint64_t seed;
+    double capacity;
+    char* end;
+    const char* output;
+    FILE* fout;
+    struct kinst inst;
+    static const struct option longOptions[] = {
+        {"class", required_argument, NULL, 'c'},
+        {"range", required_argument, NULL, 'r'},
+        {"capacity", required_argument, NULL, 'C'},
+        {"limit", required_argument, NULL, 'l'},
+        {"seed", required_argument, NULL, 's'},
+        {"binary", no_argument, NULL, 'b'},
+        {"wide", no_argument, NULL, 'w'},
+        {NULL, 0, NULL, 0}
+    };
+    programName = argv[0];
+    class = KGEN_UNCORRELATED;
+    range = 1000;
+    capacity = 0.5;
+    limit = -1;
+    seed = 1;
+    binary = 0;
+    flags = 0;
+    while ((opt = getopt_long(argc,argv,"",longOptions,NULL)) != -1) {
+        switch (opt) {
+        case 'c':
+            for (class = 0;class < (int)(sizeof(classNames)/sizeof(classNames[0]));++class)
+                if (strcmp(optarg,classNames[class]) == 0)
+                    break;
+            if (class == (int)(sizeof(classNames)/sizeof(classNames[0]))) {
+                fprintf(stderr,"%s: unknown class '%s'\n",programName,optarg);
+                usage();
+            }
+            break;
+        case 'r':
+            if (!parse_unsigned(optarg,KGEN_MAX_RANGE,&n) || n == 0) {
+                fprintf(stderr,"%s: range must be between 1 and %d\n",programName,KGEN_MAX_RANGE);
+                usage();
+            }
+            range = (int)n;
+            break;
+        case 'C':
+            errno = 0;
+            capacity = strtod(optarg,&end);
+            if (errno!=0 || end==optarg || *end!=0 || !(capacity>0.0 && capacity<=1.0)) {
+                fprintf(stderr,"%s: capacity must be a fraction in (0,1]\n",programName);
+                usage();
+            }
+            break;
+        case 'l':
+            if (!parse_unsigned(optarg,INT_MAX,&n)) {
+                fprintf(stderr,"%s: limit must be between 0 and %d\n",programName,INT_MAX);
+                usage();
+            }
+            limit = (long long)n;
+            break;
+        case 's':
+            if (!parse_unsigned(optarg,ULLONG_MAX,&n)) {
+                fprintf(stderr,"%s: bad seed '%s'\n",programName,optarg);
+                usage();
+            }
+            seed = n;
+            break;
+        case 'b':
+            binary = 1;
+            break;
+        case 'w':
+            flags |= KINST_WIDE;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (argc-optind<1 || argc-optind>2)
+        usage();
+    if (!parse_unsigned(argv[optind],SIZE_MAX/sizeof(int),&n) || n == 0) {
+        fprintf(stderr,"%s: bad item count '%s'\n",programName,argv[optind]);
+        usage();
+    }
+    output = argc-optind==2 ? argv[optind+1] : "-";
+
+    memset(&inst,0,sizeof(struct kinst));
+    inst.count = (size_t)n;
+    inst.cost = malloc(sizeof(int) * inst.count);
+    inst.value = malloc(sizeof(int) * inst.count);
+    if (inst.cost==NULL || inst.value==NULL) {
+        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
+        exit(EXIT_FAILURE);
+    }
+    generate(&inst,class,range,seed);
+    if (limit < 0) {
+        /* a fraction of the total cost; large instances are clamped since the
+           cost limit is an int */
+        long double total = 0;
+        size_t i;
+        for (i = 0;i < inst.count;++i)
+            total += inst.cost[i];
+        total *= capacity;
+        if (total > INT_MAX) {
+            fprintf(stderr,"%s: cost limit clamped to %d\n",programName,INT_MAX);
+            total = INT_MAX;
+        }
+        limit = (long long)total;
+    }
+    inst.limit = (int)limit;
+
+    if (strcmp(output,"-") == 0)
+        fout = stdout;
+    else if ((fout = fopen(output,"wb")) == NULL) {
+        fprintf(stderr,"%s: cannot open '%s': %s\n",programName,output,strerror(errno));
+        return EXIT_FAILURE;
+    }
+    ok = binary ? kinst_write_binary(&inst,fout,flags) : write_csv(&inst,fout);
+    if (!ok)
+        fprintf(stderr,"%s: cannot write '%s': %s\n",programName,output,strerror(errno));
+    if (fout!=stdout && fclose(fout)!=0 && ok) {
+        fprintf(stderr,"%s: cannot write '%s': %s\n",programName,output,strerror(errno));
+        ok = 0;
+    }
+    free(inst.cost);
+    free(inst.value);
+    return ok ? 0 : EXIT_FAILURE;
+}
+
+void usage()
+{
+    fprintf(stderr,"usage: %s [options] count [output]\n",programName);
+    fprintf(stderr,"  writes 'count' items to 'output' (default stdout)\n");
+    fprintf(stderr,"  --class=C       uncorrelated (default), weak, strong, inverse or subset-sum\n");
+    fprintf(stderr,"  --range=R       costs (values for inverse) are drawn from [1,R]; default 1000\n");
+    fprintf(stderr,"  --capacity=F    cost limit as a fraction of the total cost; default 0.5\n");
+    fprintf(stderr,"  --limit=N       use N as the cost limit\n");
+    fprintf(stderr,"  --seed=S        random seed; the same seed gives the same instance; default 1\n");
+    fprintf(stderr,"  --binary        write the binary format instead of CSV\n");
+    fprintf(stderr,"  --wide          write 64-bit cost and value arrays (binary only)\n");
+    exit(EXIT_FAILURE);
+}
+
+int parse_unsigned(const char* arg,unsigned long long max,unsigned long long* result)
+{
+    char* end;
+    errno = 0;
+    if (*arg<'0' || *arg>'9')
+        return 0;
+    *result = strtoull(arg,&end,10);
+    return errno==0 && *end==0 && *result<=max;
+}
+
+/* splitmix64; every state gives a well mixed output, so any seed will do */
+uint64_t rng_next(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* uniform in [lo,hi] by scaling the high 32 bits; a value's probability is off
+   by at most one part in 2^32, which is negligible for instance generation */
+int rng_range(uint64_t* state,int lo,int hi)
+{
+    uint64_t span = (uint64_t)(hi - lo) + 1;
+    return lo + (int)(((rng_next(state) >> 32) * span) >> 32);
+}
+
+/* the classes of Pisinger's "Where are the hard knapsack problems?" */
+void generate(struct kinst* inst,int class,int range,uint64_t seed)
+{
+    size_t i;
+    int c, v, d;
+    uint64_t state = seed;
+    d = range / 10;
+    for (i = 0;i < inst->count;++i) {
+        switch (class) {
+        case KGEN_WEAK:
+            c = rng_range(&state,1,range);
+            v = rng_range(&state,c-d < 1 ? 1 : c-d,c+d);
+            break;
+        case KGEN_STRONG:
+            c = rng_range(&state,1,range);
+            v = c + d;
+            break;
+        case KGEN_INVERSE:
+            v = rng_range(&state,1,range);
+            c = v + d;
+            break;
+        case KGEN_SUBSET_SUM:
+            c = v = rng_range(&state,1,range);
+            break;
+        default:
+            c = rng_range(&state,1,range);
+            v = rng_range(&state,1,range);
+            break;
+        }
+        inst->cost[i] = c;
+        inst->value[i] = v;
+    }
+}
+
+char* put_uint(char* p,unsigned long v)
+{
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = '0' + v%10;
+        v /= 10;
+    } while (v > 0);
+    while (n > 0)
+        *p++ = digits[--n];
+    return p;
+}
+
+/* items are named by their number, the same names the loader gives binary
+   instances without names; lines are formatted by hand into a large buffer
+   since fprintf() is the bottleneck at this volume */
+int write_csv(const struct kinst* inst,FILE* out)
+{
+    size_t i;
+    char* buffer, *p;
+    buffer = malloc(KGEN_BUFFER_SIZE);
+    if (buffer == NULL) {
+        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
+        exit(EXIT_FAILURE);
+    }
+    p = put_uint(buffer,inst->limit);
+    *p++ = '\n';
+    for (i = 0;i < inst->count;++i) {
+        if (p-buffer > KGEN_BUFFER_SIZE-KGEN_MAX_LINE) {
+            if (fwrite(buffer,1,p-buffer,out) != (size_t)(p-buffer)) {
+                free(buffer);
+                return 0;
+            }
+            p = buffer;
+        }
+        p = put_uint(p,i+1);
+        *p++ = ',';
+        p = put_uint(p,inst->cost[i]);
+        *p++ = ',';
+        p = put_uint(p,inst->value[i]);
+        *p++ = '\n';
+    }
+    if (fwrite(buffer,1,p-buffer,out) != (size_t)(p-buffer)) {
+        free(buffer);
+        return 0;
+    }
+    free(buffer);
+    return fflush(out) == 0;
+}
@@ -0,0 +1,378 @@
+/* knapsack-instance.c - shared loader for knapsack problem instances */
+#include "knapsack-instance.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int kinst_read_fd(struct kinst* inst,int fd)
+{
+    /* read the whole stream into a heap buffer with buffered reads */
+    size_t cap = 1 << 16;
+    inst->data = malloc(cap);
+    inst->dataSz = 0;
+    if (inst->data == NULL)
+        return 0;
+    while (1) {
+        ssize_t n;
+        if (inst->dataSz == cap) {
+            char* newblock;
+            cap <<= 1;
+            newblock = realloc(inst->data,cap);
+            if (newblock == NULL)
+                return 0;
+            inst->data = newblock;
+        }
+        n = read(fd,inst->data+inst->dataSz,cap-inst->dataSz);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        if (n == 0)
+            break;
+        inst->dataSz += n;
+    }
+    return 1;
+}
+static int kinst_map(struct kinst* inst,int fd)
+{
+    /* map a regular file privately so that CSV names can be terminated in
+       place without touching the file; binary files are never written so
+       they are mapped shared and read-only */
+    struct stat st;
+    void* addr;
+    char magic[4];
+    if (fstat(fd,&st)!=0 || !S_ISREG(st.st_mode) || st.st_size==0)
+        return 0;
+    if (pread(fd,magic,sizeof(magic),0)==sizeof(magic) && memcmp(magic,KINST_MAGIC,sizeof(magic))==0)
+        addr = mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+    else
+        addr = mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+    if (addr == MAP_FAILED)
+        return 0;
+    madvise(addr,st.st_size,MADV_SEQUENTIAL);
+    inst->data = addr;
+    inst->dataSz = st.st_size;
+    inst->mapped = 1;
+    return 1;
+}
+static inline int is_blank(char c)
+{
+    return c==' ' || c=='\t' || c=='\r';
+}
+static const char* scan_int(const char* p,const char* end,int* result)
+{
+    /* parse a decimal integer surrounded by blanks; NULL is returned if the
+       field is not exactly one integer */
+    int neg = 0;
+    long long n = 0;
+    const char* digits;
+    while (p<end && is_blank(*p))
+        ++p;
+    if (p<end && (*p=='-' || *p=='+'))
+        neg = *p++ == '-';
+    digits = p;
+    while (p<end && *p>='0' && *p<='9') {
+        n = n*10 + (*p++ - '0');
+        if (n > (long long)INT_MAX+1)
+            return NULL;
+    }
+    if (p==digits || (!neg && n>INT_MAX))
+        return NULL;
+    while (p<end && is_blank(*p))
+        ++p;
+    *result = neg ? (int)-n : (int)n;
+    return p;
+}
+static int kinst_parse_csv(struct kinst* inst,const char* name,char* err,size_t errSz)
+{
+    size_t lines;
+    char* p, *end, *eol;
+    p = inst->data;
+    end = p + inst->dataSz;
+    /* the number of lines bounds the number of items */
+    lines = 1;
+    for (eol = p;(eol = memchr(eol,'\n',end-eol)) != NULL;++eol)
+        ++lines;
+    inst->ownArrays = 1;
+    inst->cost = malloc(sizeof(int) * lines);
+    inst->value = malloc(sizeof(int) * lines);
+    inst->names = malloc(sizeof(const char*) * lines);
+    if (inst->cost==NULL || inst->value==NULL || inst->names==NULL) {
+        snprintf(err,errSz,"memory exception: fail malloc()");
+        return 0;
+    }
+    /* read in knapsack limit */
+    eol = memchr(p,'\n',end-p);
+    if (eol == NULL)
+        eol = end;
+    if (scan_int(p,eol,&inst->limit) != eol) {
+        snprintf(err,errSz,"format error in file '%s': <cost-limit> field was not an integer",name);
+        return 0;
+    }
+    /* read in set of possible items: name,cost,value */
+    inst->count = 0;
+    for (p = eol+1;p < end;p = eol+1) {
+        char* s, *comma;
+        const char* q;
+        eol = memchr(p,'\n',end-p);
+        if (eol == NULL)
+            eol = end;
+        s = p;
+        while (s<eol && is_blank(*s))
+            ++s;
+        if (s == eol)
+            /* skip blank lines */
+            continue;
+        comma = memchr(s,',',eol-s);
+        if (comma == NULL)
+            goto bad_item;
+        inst->names[inst->count] = s;
+        q = scan_int(comma+1,eol,inst->cost+inst->count);
+        if (q==NULL || q==eol || *q!=',')
+            goto bad_item;
+        q = scan_int(q+1,eol,inst->value+inst->count);
+        if (q==NULL || (q!=eol && *q!=','))
+            goto bad_item;
+        /* terminate the name in place */
+        while (comma>s && is_blank(comma[-1]))
+            --comma;
+        *comma = 0;
+        ++inst->count;
+    }
+    return 1;
+bad_item:
+    snprintf(err,errSz,"format error in file '%s': bad item format for item %zu",name,inst->count+1);
+    return 0;
+}
+static inline size_t align8(size_t n)
+{
+    return (n+7) & ~(size_t)7;
+}
+static int kinst_copy_wide(int* dst,const char* src,size_t cnt)
+{
+    /* narrow an int64_t array to int; fails if a value does not fit */
+    size_t i;
+    for (i = 0;i < cnt;++i) {
+        int64_t n;
+        memcpy(&n,src + i*sizeof(int64_t),sizeof(int64_t));
+        if (n<INT_MIN || n>INT_MAX)
+            return 0;
+        dst[i] = (int)n;
+    }
+    return 1;
+}
+static int kinst_parse_binary(struct kinst* inst,const char* name,char* err,size_t errSz)
+{
+    size_t i, width, need, costOff, valueOff, offsetsOff, namesOff;
+    struct kinst_header hdr;
+    if (inst->dataSz < sizeof(struct kinst_header)) {
+        snprintf(err,errSz,"format error in file '%s': truncated header",name);
+        return 0;
+    }
+    memcpy(&hdr,inst->data,sizeof(struct kinst_header));
+    if (hdr.version != KINST_VERSION) {
+        snprintf(err,errSz,"format error in file '%s': unsupported version %u",name,(unsigned)hdr.version);
+        return 0;
+    }
+    if (hdr.byteOrder != KINST_BYTE_ORDER) {
+        snprintf(err,errSz,"format error in file '%s': written with a different byte order",name);
+        return 0;
+    }
+    if (hdr.limit<INT_MIN || hdr.limit>INT_MAX) {
+        snprintf(err,errSz,"format error in file '%s': <cost-limit> field is out of range",name);
+        return 0;
+    }
+    /* compute the layout; every item needs at least 8 bytes so the count is
+       bounded by the file size before any of the sums can overflow */
+    width = (hdr.flags & KINST_WIDE) ? sizeof(int64_t) : sizeof(int32_t);
+    if (hdr.count > inst->dataSz/8 || hdr.nameBytes > inst->dataSz) {
+        snprintf(err,errSz,"format error in file '%s': truncated item data",name);
+        return 0;
+    }
+    costOff = sizeof(struct kinst_header);
+    valueOff = align8(costOff + width*hdr.count);
+    offsetsOff = align8(valueOff + width*hdr.count);
+    namesOff = offsetsOff;
+    if (hdr.flags & KINST_NAMES)
+        namesOff += sizeof(uint64_t)*hdr.count;
+    need = namesOff + ((hdr.flags & KINST_NAMES) ? hdr.nameBytes : 0);
+    if (need > inst->dataSz) {
+        snprintf(err,errSz,"format error in file '%s': truncated item data",name);
+        return 0;
+    }
+    inst->limit = (int)hdr.limit;
+    inst->count = hdr.count;
+    inst->names = malloc(sizeof(const char*) * (hdr.count+1));
+    if (inst->names == NULL) {
+        snprintf(err,errSz,"memory exception: fail malloc()");
+        return 0;
+    }
+    if (width==sizeof(int32_t) && sizeof(int)==sizeof(int32_t)) {
+        /* use the arrays in place */
+        inst->cost = (int*)(inst->data + costOff);
+        inst->value = (int*)(inst->data + valueOff);
+    }
+    else {
+        inst->ownArrays = 1;
+        inst->cost = malloc(sizeof(int) * (hdr.count+1));
+        inst->value = malloc(sizeof(int) * (hdr.count+1));
+        if (inst->cost==NULL || inst->value==NULL) {
+            snprintf(err,errSz,"memory exception: fail malloc()");
+            return 0;
+        }
+        if (!kinst_copy_wide(inst->cost,inst->data+costOff,hdr.count)
+            || !kinst_copy_wide(inst->value,inst->data+valueOff,hdr.count))
+        {
+            snprintf(err,errSz,"format error in file '%s': item field is out of range",name);
+            return 0;
+        }
+    }
+    if (hdr.flags & KINST_NAMES) {
+        const char* blob = inst->data + namesOff;
+        if (hdr.nameBytes>0 && blob[hdr.nameBytes-1]!=0) {
+            snprintf(err,errSz,"format error in file '%s': name table is not terminated",name);
+            return 0;
+        }
+        for (i = 0;i < hdr.count;++i) {
+            uint64_t off;
+            memcpy(&off,inst->data + offsetsOff + i*sizeof(uint64_t),sizeof(uint64_t));
+            if (off >= hdr.nameBytes) {
+                snprintf(err,errSz,"format error in file '%s': bad name offset for item %zu",name,i+1);
+                return 0;
+            }
+            inst->names[i] = blob + off;
+        }
+    }
+    else {
+        /* name the items by their position */
+        char* p;
+        inst->nameArena = malloc(hdr.count*21 + 1);
+        if (inst->nameArena == NULL) {
+            snprintf(err,errSz,"memory exception: fail malloc()");
+            return 0;
+        }
+        p = inst->nameArena;
+        for (i = 0;i < hdr.count;++i) {
+            inst->names[i] = p;
+            p += sprintf(p,"%zu",i+1) + 1;
+        }
+    }
+    return 1;
+}
+struct kinst* kinst_load(const char* path,const char* name,char* err,size_t errSz)
+{
+    int fd;
+    struct kinst* inst;
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    inst = malloc(sizeof(struct kinst));
+    if (inst == NULL) {
+        snprintf(err,errSz,"memory exception: fail malloc()");
+        return NULL;
+    }
+    memset(inst,0,sizeof(struct kinst));
+    if (path == NULL)
+        fd = STDIN_FILENO;
+    else if ((fd = open(path,O_RDONLY)) < 0) {
+        snprintf(err,errSz,"cannot open '%s': %s",name,strerror(errno));
+        free(inst);
+        return NULL;
+    }
+    if (!kinst_map(inst,fd) && !kinst_read_fd(inst,fd)) {
+        snprintf(err,errSz,"cannot read '%s': %s",name,strerror(errno));
+        if (path != NULL)
+            close(fd);
+        kinst_free(inst);
+        return NULL;
+    }
+    if (path != NULL)
+        close(fd);
+    inst->bytes = inst->dataSz;
+    if (inst->dataSz>=4 && memcmp(inst->data,KINST_MAGIC,4)==0)
+        inst->format = KINST_FORMAT_BINARY;
+    else
+        inst->format = KINST_FORMAT_CSV;
+    if ( !(inst->format==KINST_FORMAT_BINARY ? kinst_parse_binary(inst,name,err,errSz) : kinst_parse_csv(inst,name,err,errSz)) ) {
+        kinst_free(inst);
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    inst->seconds = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    return inst;
+}
+void kinst_free(struct kinst* inst)
+{
+    if (inst->mapped)
+        munmap(inst->data,inst->dataSz);
+    else
+        free(inst->data);
+    if (inst->ownArrays) {
+        free(inst->cost);
+        free(inst->value);
+    }
+    free(inst->names);
+    free(inst->nameArena);
+    free(inst);
+}
+static int write_padded(const void* buf,size_t sz,FILE* out)
+{
+    static const char zeros[8];
+    size_t pad = align8(sz) - sz;
+    return fwrite(buf,1,sz,out)==sz && fwrite(zeros,1,pad,out)==pad;
+}
+static int write_array(const int* a,size_t cnt,int wide,FILE* out)
+{
+    size_t i;
+    if (!wide)
+        return write_padded(a,sizeof(int32_t)*cnt,out);
+    for (i = 0;i < cnt;++i) {
+        int64_t n = a[i];
+        if (fwrite(&n,sizeof(int64_t),1,out) != 1)
+            return 0;
+    }
+    return 1;
+}
+int kinst_write_binary(const struct kinst* inst,FILE* out,unsigned flags)
+{
+    size_t i;
+    uint64_t off;
+    struct kinst_header hdr;
+    memset(&hdr,0,sizeof(struct kinst_header));
+    memcpy(hdr.magic,KINST_MAGIC,sizeof(hdr.magic));
+    hdr.version = KINST_VERSION;
+    hdr.byteOrder = KINST_BYTE_ORDER;
+    hdr.flags = flags & (KINST_WIDE|KINST_NAMES);
+    hdr.limit = inst->limit;
+    hdr.count = inst->count;
+    if (flags & KINST_NAMES)
+        for (i = 0;i < inst->count;++i)
+            hdr.nameBytes += strlen(inst->names[i]) + 1;
+    if (fwrite(&hdr,sizeof(struct kinst_header),1,out) != 1
+        || !write_array(inst->cost,inst->count,flags & KINST_WIDE,out)
+        || !write_array(inst->value,inst->count,flags & KINST_WIDE,out))
+        return 0;
+    if (flags & KINST_NAMES) {
+        off = 0;
+        for (i = 0;i < inst->count;++i) {
+            if (fwrite(&off,sizeof(uint64_t),1,out) != 1)
+                return 0;
+            off += strlen(inst->names[i]) + 1;
+        }
+        for (i = 0;i < inst->count;++i)
+            if (fputs(inst->names[i],out)==EOF || fputc(0,out)==EOF)
+                return 0;
+    }
+    return fflush(out) == 0;
+}
+double kinst_throughput(const struct kinst* inst)
+{
+    return inst->seconds>0.0 ? inst->bytes / inst->seconds / 1e6 : 0.0;
+}
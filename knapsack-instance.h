@@ -0,0 +1,82 @@
+/* knapsack-instance.h - shared loader for knapsack problem instances; the
+   instance file is mapped into memory and parsed in place, so item names point
+   into the mapping instead of being copied */
+#ifndef KNAPSACK_INSTANCE_H
+#define KNAPSACK_INSTANCE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* binary instance format (version 1); all fields are in the byte order of the
+   machine that wrote the file, which is recorded in the header:
+
+       header      struct kinst_header
+       cost        int32_t[count] or int64_t[count] (KINST_WIDE)
+       value       same as cost
+       offsets     uint64_t[count] (KINST_NAMES); offset of each name in the blob
+       names       char[nameBytes] (KINST_NAMES); NUL-terminated names
+
+   each array starts on an 8 byte boundary */
+#define KINST_MAGIC "KNAP"
+#define KINST_VERSION 1
+#define KINST_BYTE_ORDER 0x01020304
+
+enum kinst_flags
+{
+    KINST_WIDE = 0x01,
+    KINST_NAMES = 0x02
+};
+
+struct kinst_header
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t flags;
+    int64_t limit;
+    uint64_t count;
+    uint64_t nameBytes;
+};
+
+enum kinst_format
+{
+    KINST_FORMAT_CSV,
+    KINST_FORMAT_BINARY
+};
+
+struct kinst
+{
+    int limit; /* total cost that must not be exceeded */
+    size_t count; /* number of items */
+    int* cost;
+    int* value;
+    const char** names; /* item names; these point into the instance data */
+
+    int format; /* kinst_format of the input */
+    size_t bytes; /* size of the instance data */
+    double seconds; /* time spent loading and parsing */
+
+    /* instance data; either a mapping of the file or a heap buffer (for stdin
+       and other files that cannot be mapped); binary instances with 32-bit
+       arrays use the data in place */
+    char* data;
+    size_t dataSz;
+    int mapped;
+    int ownArrays;
+    char* nameArena; /* generated names for binary instances without names */
+};
+
+/* load the instance in 'path' or standard input if 'path' is NULL; 'name' is
+   used in error messages; NULL is returned on error and a message is written
+   to 'err' */
+struct kinst* kinst_load(const char* path,const char* name,char* err,size_t errSz);
+void kinst_free(struct kinst* inst);
+
+/* write the instance in the binary format using kinst_flags; zero is returned
+   and errno is set on failure */
+int kinst_write_binary(const struct kinst* inst,FILE* out,unsigned flags);
+
+/* parse throughput in MB/s */
+double kinst_throughput(const struct kinst* inst);
+
+#endif
@@ -0,0 +1,202 @@
+/* knapsack.h - libknapsack: solvers for the 0/1 knapsack problem over items
+   held in memory; a problem is built once from cost and value arrays, which
+   computes the greedy and LP bounds and fixes items by reduction, and can then
+   be solved by any of the algorithms any number of times; nothing is printed
+   and running out of memory is returned to the caller as an error */
+#ifndef KNAPSACK_H
+#define KNAPSACK_H
+#include <stddef.h>
+
+/* algorithms; all but the FPTAS are exact */
+enum knapsack_algorithm
+{
+    KNAPSACK_OPTIMIZED1, /* exhaustive search that prunes on the cost limit */
+    KNAPSACK_OPTIMIZED2, /* ...and on the greedy lower bound */
+    KNAPSACK_OPTIMIZED, /* branch and bound with the LP bound */
+    KNAPSACK_PARALLEL, /* the same on several threads */
+    KNAPSACK_BEST_FIRST, /* branch and bound that expands the open node of highest LP bound first */
+    KNAPSACK_DP, /* dynamic programming over the capacities; a bitset of the reachable sums for subset-sum instances */
+    KNAPSACK_FPTAS, /* (1-epsilon)-approximation by DP over scaled values; not exact unless the scale is 1 */
+    KNAPSACK_MITM, /* meet in the middle; at most KNAPSACK_MITM_MAX_ITEMS free items */
+    KNAPSACK_BRUTEFORCE, /* every subset */
+    KNAPSACK_ALGORITHM_COUNT
+};
+#define KNAPSACK_MITM_MAX_ITEMS 64
+
+/* negative return values of knapsack_solve() and knapsack_solve_limits() */
+enum knapsack_error
+{
+    KNAPSACK_UNSUPPORTED = -1, /* the algorithm cannot take the problem */
+    KNAPSACK_NO_MEMORY = -2 /* an allocation failed */
+};
+
+/* command-line name and title of an algorithm; knapsack_algorithm_find()
+   returns -1 for an unknown name */
+const char* knapsack_algorithm_name(int algorithm);
+const char* knapsack_algorithm_title(int algorithm);
+int knapsack_algorithm_find(const char* name);
+
+/* order in which the exhaustive searches (bruteforce, optimized1 and
+   optimized2), the DP and meet in the middle take the free items; the branch
+   and bound searches always take them by ratio since their bound needs it */
+enum knapsack_order
+{
+    KNAPSACK_ORDER_RATIO, /* decreasing value/cost ratio; equal ratios: cheaper first */
+    KNAPSACK_ORDER_VALUE, /* decreasing value; equal values: cheaper first */
+    KNAPSACK_ORDER_COST, /* increasing cost; equal costs: more valuable first */
+    KNAPSACK_ORDER_INPUT, /* the order the items were given in */
+    KNAPSACK_ORDER_COUNT
+};
+
+struct knapsack_options
+{
+    int reduce; /* fix variables with reduction tests before the exact search */
+    int localSearch; /* improve the best greedy sack by local search */
+    int order; /* a knapsack_order value */
+    /* let the searches other than bruteforce branch on how many items of a
+       class of identical (same cost and value) items to take, instead of on
+       each item, which skips the symmetric subsets */
+    int collapse;
+    int threads; /* number of threads used by the parallel search */
+    int splitDepth; /* depth at which the parallel search tree is split into tasks; 0 picks one */
+    /* bytes the best-first queue may take; past that, new subtrees are
+       searched depth-first instead of being queued */
+    size_t queueMemory;
+    double epsilon; /* the FPTAS sack is worth at least (1-epsilon) times the optimum; in (0,1) */
+    double timeLimit; /* seconds each branch and bound search may run; 0 for no limit */
+    /* if set, called each time a branch and bound search under a time limit
+       improves its best sack, with the value of the sack, the LP bound of the
+       problem and the seconds since the search started; the parallel search
+       calls it from its threads */
+    void (*incumbent)(void* arg,int value,int upper,double seconds);
+    void* arg;
+};
+/* the defaults: reduction, local search and collapsing on, ratio order, one
+   thread per online processor, a 256 MiB best-first queue, epsilon 0.1, no
+   time limit */
+void knapsack_options_init(struct knapsack_options* opts);
+
+/* a set of items by their index into the problem's arrays */
+struct knapsack_sack
+{
+    int cost;
+    int value;
+    size_t cnt;
+    size_t* items;
+};
+
+enum knapsack_greedy
+{
+    KNAPSACK_GREEDY_VALUE, /* items by decreasing value */
+    KNAPSACK_GREEDY_COST, /* items by increasing cost */
+    KNAPSACK_GREEDY_RATIO, /* items by decreasing value/cost ratio */
+    KNAPSACK_GREEDY_COUNT
+};
+
+/* bounds and reduction computed when the problem is built */
+struct knapsack_bounds
+{
+    struct knapsack_sack greedy[KNAPSACK_GREEDY_COUNT];
+    int greedyLower; /* value of the best greedy sack */
+    /* local search from the best greedy sack with add, drop-and-refill,
+       1-swap and 2-swap moves; empty if it is turned off */
+    struct knapsack_sack local;
+    size_t localMoves; /* improving moves made */
+    double localSeconds;
+    int lower; /* value of the best sack of the heuristics */
+    /* LP relaxation (partial knapsack): whole items plus part of the critical item */
+    int partialCost;
+    double partialValue;
+    size_t partialCnt, partCnt;
+    size_t* partialItems; /* items taken whole */
+    size_t* partItems; /* items taken in part */
+    int upper; /* partialValue rounded down */
+    /* reduction; every item is free if it is turned off */
+    size_t fixedIn, fixedOut;
+    size_t freeCnt; /* items left to the exact algorithms */
+    size_t classCnt; /* classes of identical items among the free items */
+    double reduceSeconds;
+};
+
+struct knapsack_thread_stats
+{
+    size_t tasks; /* tasks the thread ran */
+    size_t steals; /* of those, tasks stolen from another thread */
+    size_t nodes;
+    double seconds;
+};
+
+struct knapsack_result
+{
+    int algorithm;
+    int limit; /* cost limit the sack was found for */
+    struct knapsack_sack sack; /* best sack, fixed items included */
+    int optimal; /* zero if a search was stopped by the time limit or the FPTAS had to round */
+    int upper; /* bound on the optimal value; equals sack.value if optimal */
+    size_t freeCnt; /* items the algorithm searched */
+    size_t leaves; /* complete sacks considered */
+    size_t nodes; /* search tree nodes visited */
+    size_t costPrunes; /* subtrees cut for exceeding the cost limit */
+    size_t boundPrunes; /* subtrees cut because they could not beat the bound */
+    double wallSeconds;
+    double cpuSeconds; /* all threads */
+    /* parallel search */
+    size_t threads, splitDepth, tasks;
+    struct knapsack_thread_stats* threadStats;
+    /* best-first search */
+    size_t expanded; /* nodes taken off the queue and branched on */
+    size_t peakQueue; /* most nodes queued at once */
+    size_t fallbacks; /* subtrees searched depth-first because the queue was full */
+    /* FPTAS */
+    double epsilon;
+    double scale; /* values were divided by this and rounded down */
+    /* dynamic programming */
+    int subsetSum; /* the items all had value equal to cost and a bitset of the reachable sums was used */
+    /* meet in the middle */
+    size_t paretoCnt[2]; /* Pareto-optimal subsets of each half */
+    size_t memory; /* peak bytes of the subset lists, the best-first queue or the subset-sum bitset */
+};
+
+/* results of knapsack_solve_limits(); one DP pass answers every limit */
+struct knapsack_limits
+{
+    int maxLimit;
+    size_t itemCnt; /* items that fit the largest limit */
+    size_t tableBytes; /* decision table; zero if each limit's items were rebuilt by divide-and-conquer */
+    double passSeconds;
+    size_t cnt;
+    struct knapsack_result* results; /* one per limit, in the order given */
+};
+
+/* the LP (fractional) upper bound in expected O(n) time without sorting the
+   items (Balas-Zemel): the critical item, the first one that no longer fits
+   when the items are taken by decreasing value/cost ratio, is found by
+   partitioning around random pivots; '*critical' is set to its index, or to
+   'cnt' if every item fits; items of no value are left out; -1 is returned
+   if memory runs out */
+double knapsack_lp_bound(const int* cost,const int* value,size_t cnt,int limit,size_t* critical);
+
+struct knapsack_problem;
+
+/* build a problem from 'cnt' items; the arrays are not copied and must
+   outlive the problem; 'opts' may be NULL for the defaults; NULL is returned
+   if a cost or value is negative or memory runs out */
+struct knapsack_problem* knapsack_problem_new(const int* cost,const int* value,size_t cnt,int limit,const struct knapsack_options* opts);
+void knapsack_problem_free(struct knapsack_problem* problem);
+const struct knapsack_bounds* knapsack_problem_bounds(const struct knapsack_problem* problem);
+
+/* solve with one of the knapsack_algorithm values; 0 is returned, or
+   KNAPSACK_UNSUPPORTED if the algorithm cannot take the problem (meet in the
+   middle with too many free items) and KNAPSACK_NO_MEMORY if an allocation
+   failed, in which cases the result holds an empty sack; a problem may be
+   solved from several threads at once */
+int knapsack_solve(const struct knapsack_problem* problem,int algorithm,struct knapsack_result* result);
+void knapsack_result_destroy(struct knapsack_result* result);
+
+/* answer the problem's items for each of 'cnt' cost limits in place of its
+   own limit; a negative limit gets an empty sack; 0 is returned, or KNAPSACK_NO_MEMORY with no results if an
+   allocation failed, which a DP row over the largest limit may well do */
+int knapsack_solve_limits(const struct knapsack_problem* problem,const int* limits,size_t cnt,struct knapsack_limits* out);
+void knapsack_limits_destroy(struct knapsack_limits* out);
+
+#endif
@@ -1,15 +1,21 @@
 /* knapsack.c - solve the knapsack problem using exhaustive search;
-   version2: add lower and upper bound computations */
+   version2: add lower and upper bound computations; the solvers live in
+   libknapsack (knapsack.h) and this file is the command-line front end */
 #include <stdlib.h>
 #include <stdio.h>
-#include <stdarg.h>
+#include <limits.h>
 #include <string.h>
-#include <ctype.h>
 #include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "knapsack.h"
+#include "knapsack-instance.h"
 #ifdef FEAT_LINUX_TINFO
 #include <curses.h>
 #include <term.h>
-#include <unistd.h>
 #endif
 
 /* terminal codes */
@@ -19,83 +25,178 @@ char TERM_SETF_BLUE[32] = "";
 char TERM_SETF_RED[32] = "";
 char TERM_SETD[32] = "";
 
-struct k_item
-{
-    int cost;
-    int value;
-    char* name;
+/* per-instance state; with -j several instances are solved at once, each in
+   its own context, and each one's output is buffered until it is complete */
+struct k_context
+{
+    const char* filename;
+    const struct kinst* inst; /* the instance being solved; its names are used for printing */
+    FILE* out;
+    FILE* stats; /* receives the statistics records in --stats mode, else NULL */
+    FILE* buffer; /* memory stream behind 'out' or 'stats' if output is buffered */
+    char* outbuf;
+    size_t outsz;
 };
-static struct k_item* k_item_new(int cost,int value,const char* name);
-static void k_item_free(struct k_item* item);
+static void k_context_init(struct k_context* ctx,const char* filename,int buffered);
+static void k_context_flush(struct k_context* ctx);
+static void k_context_print_items(struct k_context* ctx,const char* label,const size_t* ids,size_t cnt);
+static void k_context_print_sack(struct k_context* ctx,const struct knapsack_sack* sack,const char* title,size_t leaves,size_t nodes);
 
-/* item comparisons (by reference-to-reference) */
-static int itemcompar_name(const struct k_item** left,const struct k_item** right);
-static int itemcompar_value(const struct k_item** left,const struct k_item** right);
-static int itemcompar_cost(const struct k_item** left,const struct k_item** right);
-static int itemcompar_ratio(const struct k_item** left,const struct k_item** right);
+static void knapsack(struct k_context* ctx,const char* path);
+static void knapsack_limits(struct k_context* ctx,const struct knapsack_problem* problem);
+static double elapsed_seconds(const struct timespec* start);
 
-struct k_sack
-{
-    int cost;
-    int value;
-    size_t itemCap, itemSz;
-    struct k_item** items;
+/* command-line options */
+struct k_options
+{
+    int algorithms[KNAPSACK_ALGORITHM_COUNT]; /* non-zero for each exact algorithm selected with -a */
+    struct knapsack_options solver; /* reduction, threads, split depth and time limit */
+    int jobs; /* number of instance files solved at once */
+    int stats; /* k_stats_format of the statistics records */
+    int* limits; /* cost limits answered in parametric mode (--limits), else NULL */
+    size_t limitCnt;
 };
-static struct k_sack* k_sack_new();
-static struct k_sack* k_sack_copy(struct k_sack* sack);
-static void k_sack_free(struct k_sack* sack);
-static void k_sack_add_item(struct k_sack* sack,struct k_item* item);
-
-struct k_partial_sack
+enum k_stats_format
 {
-    int cost;
-    double value; /* needs fractional component */
-    /* items[0] are complete items; items[1] are partial */
-    size_t itemCap[2], itemSz[2];
-    struct k_item** items[2];
+    K_STATS_NONE,
+    K_STATS_JSON,
+    K_STATS_CSV
 };
-static struct k_partial_sack* k_partial_sack_new();
-static void k_partial_sack_free(struct k_partial_sack* psack);
-static void k_partial_sack_add_item(struct k_partial_sack* psack,struct k_item* item,int cost);
-static void k_partial_sack_print(struct k_partial_sack* psack,const char* title);
-
-struct k_solution
-{
-    size_t sackCounter; /* number of sacks considered before solution */
-    size_t nodeCounter; /* number of potential nodes processed during a solution run */
-    struct k_sack* sack; /* solution knapsack */
+static struct k_options globlOptions;
+static int exitStatus; /* EXIT_FAILURE once an algorithm could not take its instance */
+static int select_algorithms(char* list);
+static int parse_count(const char* arg,int least);
+static double parse_seconds(const char* arg);
+static double parse_epsilon(const char* arg);
+static int parse_limits(char* list);
+static FILE* nullOutput; /* the report is written here in --stats mode */
+static const char* const orderNames[KNAPSACK_ORDER_COUNT] = {
+    "ratio", "value", "cost", "input"
 };
-static struct k_solution* globlSolution;
-static struct k_solution* k_solution_new();
-static void k_solution_free(struct k_solution* sol);
-static int k_solution_check_sack(struct k_solution* sol,struct k_sack* sack);
-static void k_solution_print(struct k_solution* sol,const char* title);
+static void knapsack_stats_header();
 
-struct k_info
-{
-    int limit; /* total cost that must not be exceeded */
-    int lowerValueBound; /* value of best greedy knapsack */
-    int upperValueBound; /* value of best partial knapsack */
+/* a batch of instance files solved by a pool of threads; every instance has its
+   own context whose buffered output is printed in input order */
+struct k_batch
+{
+    char** files;
+    size_t cnt;
+    size_t next; /* index of the next file to be claimed by a thread */
+    struct k_context* contexts;
+    int* done;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
 };
-static struct k_info globlInfo;
-static void k_info_init();
-static inline void k_info_update_lower_value_bound(struct k_solution* sol);
-
-/* solution functionality */
-static void knapsack(FILE* file,const char* filename);
-static void knapsack_bruteforce_recursive(struct k_item** item,struct k_sack* sack);
-static void knapsack_optimized1_recursive(struct k_item** item,struct k_sack* sack);
-static int knapsack_optimized2_recursive(struct k_item** item,struct k_sack* sack);
-static void knapsack_optimized3(struct k_item** item);
-static struct k_solution* greedy_highest_value(struct k_item** items,size_t cnt);
-static struct k_solution* greedy_lowest_cost(struct k_item** items,size_t cnt);
-static struct k_solution* greedy_highest_ratio(struct k_item** items,size_t cnt);
-static struct k_partial_sack* partial_knapsack(struct k_item** items,size_t cnt);
+static void knapsack_batch(char** files,size_t cnt);
 
 static const char* programName;
-int main(int argc,const char* argv[])
+static void usage()
 {
+    int i;
+    fprintf(stderr,"usage: %s [-a algorithm[,algorithm...]] [-t threads] [--split-depth=depth] [--queue-memory=MiB] [--no-reduce] [--no-local-search] [--no-collapse] [--order=ratio|value|cost|input] [--epsilon=E] [-j jobs] [--time-limit=seconds] [--stats=json|csv] [--limits=limit[,limit...]] [file...]\n",programName);
+    fprintf(stderr,"algorithms:");
+    for (i = 0;i < KNAPSACK_ALGORITHM_COUNT;++i)
+        fprintf(stderr," %s",knapsack_algorithm_name(i));
+    fprintf(stderr," (default: optimized,bruteforce)\n");
+    fprintf(stderr,"the local search report gives the gain in lower bound; the drop in explored nodes is\n"
+        "measured by comparing the node counts against a run with --no-local-search\n");
+    exit(EXIT_FAILURE);
+}
+int main(int argc,char* argv[])
+{
+    int opt, i;
+    static const struct option longOptions[] = {
+        {"algorithms", required_argument, NULL, 'a'},
+        {"threads", required_argument, NULL, 't'},
+        {"split-depth", required_argument, NULL, 'd'},
+        {"queue-memory", required_argument, NULL, 'Q'},
+        {"no-reduce", no_argument, NULL, 'R'},
+        {"no-local-search", no_argument, NULL, 'N'},
+        {"no-collapse", no_argument, NULL, 'C'},
+        {"order", required_argument, NULL, 'O'},
+        {"epsilon", required_argument, NULL, 'E'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"time-limit", required_argument, NULL, 'T'},
+        {"stats", required_argument, NULL, 'S'},
+        {"limits", required_argument, NULL, 'L'},
+        {NULL, 0, NULL, 0}
+    };
     programName = argv[0];
+    globlOptions.algorithms[KNAPSACK_OPTIMIZED] = 1;
+    globlOptions.algorithms[KNAPSACK_BRUTEFORCE] = 1;
+    knapsack_options_init(&globlOptions.solver);
+    globlOptions.jobs = 1;
+    globlOptions.stats = K_STATS_NONE;
+    globlOptions.limits = NULL;
+    globlOptions.limitCnt = 0;
+    while ((opt = getopt_long(argc,argv,"a:t:d:j:",longOptions,NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            if ( !select_algorithms(optarg) )
+                usage();
+            break;
+        case 't':
+            if ((globlOptions.solver.threads = parse_count(optarg,1)) < 0)
+                usage();
+            break;
+        case 'd':
+            if ((globlOptions.solver.splitDepth = parse_count(optarg,1)) < 0)
+                usage();
+            break;
+        case 'Q':
+            if ((i = parse_count(optarg,1)) < 0)
+                usage();
+            globlOptions.solver.queueMemory = (size_t)i << 20;
+            break;
+        case 'R':
+            globlOptions.solver.reduce = 0;
+            break;
+        case 'N':
+            globlOptions.solver.localSearch = 0;
+            break;
+        case 'C':
+            globlOptions.solver.collapse = 0;
+            break;
+        case 'O':
+            for (i = 0;i < KNAPSACK_ORDER_COUNT;++i)
+                if (strcmp(optarg,orderNames[i]) == 0)
+                    break;
+            if (i == KNAPSACK_ORDER_COUNT) {
+                fprintf(stderr,"%s: unknown order '%s'\n",programName,optarg);
+                usage();
+            }
+            globlOptions.solver.order = i;
+            break;
+        case 'E':
+            if ((globlOptions.solver.epsilon = parse_epsilon(optarg)) < 0.0)
+                usage();
+            break;
+        case 'j':
+            if ((globlOptions.jobs = parse_count(optarg,1)) < 0)
+                usage();
+            break;
+        case 'T':
+            if ((globlOptions.solver.timeLimit = parse_seconds(optarg)) < 0.0)
+                usage();
+            break;
+        case 'S':
+            if (strcmp(optarg,"json") == 0)
+                globlOptions.stats = K_STATS_JSON;
+            else if (strcmp(optarg,"csv") == 0)
+                globlOptions.stats = K_STATS_CSV;
+            else {
+                fprintf(stderr,"%s: unknown statistics format '%s'\n",programName,optarg);
+                usage();
+            }
+            break;
+        case 'L':
+            if ( !parse_limits(optarg) )
+                usage();
+            break;
+        default:
+            usage();
+        }
+    }
 #ifdef FEAT_LINUX_TINFO
     /* setup terminal information if stdout is a terminal */
     if (isatty(STDOUT_FILENO)) {
@@ -109,574 +210,555 @@ int main(int argc,const char* argv[])
         }
     }
 #endif
+    if (globlOptions.stats != K_STATS_NONE) {
+        if ((nullOutput = fopen("/dev/null","w")) == NULL) {
+            fprintf(stderr,"%s: cannot open '/dev/null': %s\n",programName,strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        if (globlOptions.stats == K_STATS_CSV)
+            knapsack_stats_header();
+    }
     /* perform knapsack computations on instance input; if no file names
        were supplied, read from standard input */
-    if (argc > 1) {
-        int i;
-        for (i = 1;i < argc;++i) {
-            FILE* fin = fopen(argv[i],"r");
-            if (fin == NULL)
-                fprintf(stderr,"%s: cannot open '%s': %s\n",argv[0],argv[i],strerror(errno));
-            else {
-                knapsack(fin,argv[i]);
-                fclose(fin);
-            }
-        }
+    if (optind < argc)
+        knapsack_batch(argv+optind,argc-optind);
+    else {
+        struct k_context ctx;
+        k_context_init(&ctx,"stdin",0);
+        knapsack(&ctx,NULL);
+        k_context_flush(&ctx);
     }
-    else
-        knapsack(stdin,"stdin");
-    return 0;
+    return exitStatus;
 }
-
-/* k_item */
-struct k_item* k_item_new(int cost,int value,const char* name)
+static void* knapsack_batch_worker(void* arg)
 {
-    size_t len;
-    struct k_item* item;
-    item = malloc(sizeof(struct k_item));
-    if (item == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-        exit(EXIT_FAILURE);
+    struct k_batch* batch = arg;
+    while (1) {
+        size_t i = __atomic_fetch_add(&batch->next,1,__ATOMIC_RELAXED);
+        if (i >= batch->cnt)
+            break;
+        knapsack(batch->contexts+i,batch->contexts[i].filename);
+        pthread_mutex_lock(&batch->lock);
+        batch->done[i] = 1;
+        pthread_cond_broadcast(&batch->cond);
+        pthread_mutex_unlock(&batch->lock);
+    }
+    return NULL;
+}
+void knapsack_batch(char** files,size_t cnt)
+{
+    size_t i, threadCnt;
+    pthread_t* threads;
+    struct k_batch batch;
+    if (globlOptions.jobs<=1 || cnt<=1) {
+        /* solve the files one after another, printing as we go */
+        for (i = 0;i < cnt;++i) {
+            struct k_context ctx;
+            k_context_init(&ctx,files[i],0);
+            knapsack(&ctx,files[i]);
+            k_context_flush(&ctx);
+        }
+        return;
     }
-    item->cost = cost;
-    item->value = value;
-    len = strlen(name);
-    item->name = malloc(len+1);
-    if (item->name == NULL) {
+    threadCnt = (size_t)globlOptions.jobs<cnt ? (size_t)globlOptions.jobs : cnt;
+    batch.files = files;
+    batch.cnt = cnt;
+    batch.next = 0;
+    batch.contexts = malloc(sizeof(struct k_context) * cnt);
+    batch.done = calloc(cnt,sizeof(int));
+    threads = malloc(sizeof(pthread_t) * threadCnt);
+    if (batch.contexts==NULL || batch.done==NULL || threads==NULL) {
         fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
         exit(EXIT_FAILURE);
     }
-    strcpy(item->name,name);
-    return item;
-}
-void k_item_free(struct k_item* item)
-{
-    free(item->name);
-    free(item);
-}
-
-int itemcompar_name(const struct k_item** left,const struct k_item** right)
-{
-    return strcmp((*left)->name,(*right)->name);
-}
-int itemcompar_value(const struct k_item** left,const struct k_item** right)
-{
-    return (*right)->value - (*left)->value;
-}
-int itemcompar_cost(const struct k_item** left,const struct k_item** right)
+    pthread_mutex_init(&batch.lock,NULL);
+    pthread_cond_init(&batch.cond,NULL);
+    for (i = 0;i < cnt;++i)
+        k_context_init(batch.contexts+i,files[i],1);
+    for (i = 0;i < threadCnt;++i) {
+        if (pthread_create(threads+i,NULL,knapsack_batch_worker,&batch) != 0) {
+            fprintf(stderr,"%s: cannot create thread: %s\n",programName,strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    }
+    /* print each instance's output as soon as it and every instance before it
+       have finished */
+    for (i = 0;i < cnt;++i) {
+        pthread_mutex_lock(&batch.lock);
+        while ( !batch.done[i] )
+            pthread_cond_wait(&batch.cond,&batch.lock);
+        pthread_mutex_unlock(&batch.lock);
+        k_context_flush(batch.contexts+i);
+    }
+    for (i = 0;i < threadCnt;++i)
+        pthread_join(threads[i],NULL);
+    pthread_mutex_destroy(&batch.lock);
+    pthread_cond_destroy(&batch.cond);
+    free(threads);
+    free(batch.done);
+    free(batch.contexts);
+}
+int select_algorithms(char* list)
 {
-    return (*left)->cost - (*right)->cost;
+    int i;
+    char* name;
+    for (i = 0;i < KNAPSACK_ALGORITHM_COUNT;++i)
+        globlOptions.algorithms[i] = 0;
+    for (name = strtok(list,",");name != NULL;name = strtok(NULL,",")) {
+        if ((i = knapsack_algorithm_find(name)) < 0) {
+            fprintf(stderr,"%s: unknown algorithm '%s'\n",programName,name);
+            return 0;
+        }
+        globlOptions.algorithms[i] = 1;
+    }
+    return 1;
 }
-int itemcompar_ratio(const struct k_item** left,const struct k_item** right)
+int parse_count(const char* arg,int least)
 {
-    double ratio[2];
-    ratio[0] = (double)(*right)->value / (*right)->cost;
-    ratio[1] = (double)(*left)->value / (*left)->cost;
-    if (ratio[0] < ratio[1])
+    long n;
+    char* end;
+    errno = 0;
+    n = strtol(arg,&end,10);
+    if (errno!=0 || *end!=0 || end==arg || n<least || n>1000000) {
+        fprintf(stderr,"%s: bad numeric argument '%s'\n",programName,arg);
         return -1;
-    else if (ratio[0] > ratio[1])
-        return 1;
-    return 0;
-}
-
-/* k_sack */
-struct k_sack* k_sack_new()
-{
-    struct k_sack* sack;
-    sack = malloc(sizeof(struct k_sack));
-    if (sack == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-        exit(EXIT_FAILURE);
-    }
-    sack->cost = sack->value = 0;
-    sack->itemCap = 4;
-    sack->itemSz = 0;
-    sack->items = malloc(sizeof(struct k_item*) * sack->itemCap);
-    if (sack->items == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-        exit(EXIT_FAILURE);
     }
-    return sack;
+    return (int)n;
 }
-struct k_sack* k_sack_copy(struct k_sack* sack)
+double parse_seconds(const char* arg)
 {
-    size_t i;
-    struct k_sack* copy;
-    copy = malloc(sizeof(struct k_sack));
-    if (copy == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-        exit(EXIT_FAILURE);
+    double n;
+    char* end;
+    errno = 0;
+    n = strtod(arg,&end);
+    if (errno!=0 || *end!=0 || end==arg || !(n > 0.0)) {
+        fprintf(stderr,"%s: bad time limit '%s'\n",programName,arg);
+        return -1.0;
     }
-    copy->cost = sack->cost;
-    copy->value = sack->value;
-    copy->itemCap = sack->itemCap;
-    copy->itemSz = sack->itemSz;
-    copy->items = malloc(sizeof(struct k_item*) * copy->itemCap);
-    if (copy->items == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-        exit(EXIT_FAILURE);
-    }
-    for (i = 0;i < copy->itemSz;++i)
-        copy->items[i] = sack->items[i];
-    return copy;
+    return n;
 }
-void k_sack_free(struct k_sack* sack)
+double parse_epsilon(const char* arg)
 {
-    free(sack->items);
-    free(sack);
+    double n;
+    char* end;
+    errno = 0;
+    n = strtod(arg,&end);
+    if (errno!=0 || *end!=0 || end==arg || !(n>0.0 && n<1.0)) {
+        fprintf(stderr,"%s: epsilon must be a fraction in (0,1): '%s'\n",programName,arg);
+        return -1.0;
+    }
+    return n;
 }
-void k_sack_add_item(struct k_sack* sack,struct k_item* item)
-{
-    if (sack->itemSz >= sack->itemCap) {
-        struct k_item** newblock;
-        sack->itemCap <<= 1;
-        newblock = realloc(sack->items,sizeof(struct k_item*)*sack->itemCap);
-        if (newblock == NULL) {
+
+int parse_limits(char* list)
+{
+    long n;
+    char* end, *arg;
+    free(globlOptions.limits);
+    globlOptions.limits = NULL;
+    globlOptions.limitCnt = 0;
+    for (arg = strtok(list,",");arg != NULL;arg = strtok(NULL,",")) {
+        errno = 0;
+        n = strtol(arg,&end,10);
+        if (errno!=0 || *end!=0 || end==arg || n<0 || n>INT_MAX) {
+            fprintf(stderr,"%s: bad cost limit '%s'\n",programName,arg);
+            return 0;
+        }
+        globlOptions.limits = realloc(globlOptions.limits,sizeof(int) * (globlOptions.limitCnt+1));
+        if (globlOptions.limits == NULL) {
             fprintf(stderr,"%s: memory exception: fail realloc()\n",programName);
             exit(EXIT_FAILURE);
         }
-        sack->items = newblock;
+        globlOptions.limits[globlOptions.limitCnt++] = (int)n;
+    }
+    if (globlOptions.limitCnt == 0) {
+        fprintf(stderr,"%s: no cost limits given\n",programName);
+        return 0;
     }
-    sack->items[sack->itemSz++] = item;
-    sack->cost += item->cost;
-    sack->value += item->value;
+    return 1;
 }
 
-/* k_partial_sack */
-struct k_partial_sack* k_partial_sack_new()
-{
-    int i;
-    struct k_partial_sack* psack;
-    psack = malloc(sizeof(struct k_partial_sack));
-    if (psack == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
+/* k_context */
+void k_context_init(struct k_context* ctx,const char* filename,int buffered)
+{
+    ctx->filename = filename;
+    ctx->inst = NULL;
+    ctx->outbuf = NULL;
+    ctx->outsz = 0;
+    ctx->buffer = NULL;
+    if (buffered && (ctx->buffer = open_memstream(&ctx->outbuf,&ctx->outsz)) == NULL) {
+        fprintf(stderr,"%s: memory exception: fail open_memstream()\n",programName);
         exit(EXIT_FAILURE);
     }
-    psack->cost = 0;
-    psack->value = 0.0;
-    for (i = 0;i < 2;++i) {
-        psack->itemCap[i] = 4;
-        psack->itemSz[i] = 0;
-        psack->items[i] = malloc(sizeof(struct k_item*) * psack->itemCap[i]);
-        if (psack->items[i] == NULL) {
-            fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-            exit(EXIT_FAILURE);
-        }
+    /* in --stats mode only the records are written out; the report is
+       discarded */
+    if (globlOptions.stats != K_STATS_NONE) {
+        ctx->out = nullOutput;
+        ctx->stats = buffered ? ctx->buffer : stdout;
+    }
+    else {
+        ctx->out = buffered ? ctx->buffer : stdout;
+        ctx->stats = NULL;
     }
-    return psack;
-}
-void k_partial_sack_free(struct k_partial_sack* psack)
-{
-    int i;
-    for (i = 0;i < 2;++i)
-        free(psack->items[i]);
-    free(psack);
 }
-void k_partial_sack_add_item(struct k_partial_sack* psack,struct k_item* item,int cost)
+void k_context_flush(struct k_context* ctx)
 {
-    int index;
-    double value = item->value;
-    value *= (double)cost / item->cost;
-    index = value < item->value ? 1 : 0;
-    if (psack->itemSz[index] >= psack->itemCap[index]) {
-        struct k_item** newblock;
-        psack->itemCap[index] <<= 1;
-        newblock = realloc(psack->items[index],sizeof(struct k_item*)*psack->itemCap[index]);
-        if (newblock == NULL) {
-            fprintf(stderr,"%s: memory exception: fail realloc()\n",programName);
-            exit(EXIT_FAILURE);
-        }
-        psack->items[index] = newblock;
+    /* write out the instance's buffered output in one piece */
+    if (ctx->buffer != NULL) {
+        fclose(ctx->buffer);
+        fwrite(ctx->outbuf,1,ctx->outsz,stdout);
+        free(ctx->outbuf);
+        if (ctx->out == ctx->buffer)
+            ctx->out = stdout;
+        if (ctx->stats == ctx->buffer)
+            ctx->stats = stdout;
+        ctx->buffer = NULL;
+        ctx->outbuf = NULL;
+        ctx->outsz = 0;
     }
-    psack->items[index][psack->itemSz[index]++] = item;
-    psack->cost += cost;
-    psack->value += value;
+    fflush(stdout);
 }
-void k_partial_sack_print(struct k_partial_sack* psack,const char* title)
+static int namecompar(const char** left,const char** right)
 {
-    if (psack->itemSz[0]==0 && psack->itemSz[1]==0)
-        printf("\t[%s%s%s%s%s] solution: empty set\n",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD);
-    else {
-        size_t i;
-        for (i = 0;i < 2;++i)
-            qsort(psack->items[i],psack->itemSz[i],sizeof(struct k_item*),(int (*)(const void*,const void*))itemcompar_name);
-        printf("\t[%s%s%s%s%s] solution: cost=%s%s%d%s%s, value=%s%s%f%s%s",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD,
-            TERM_SETF_RED,TERM_BOLD,psack->cost,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,psack->value,TERM_SGR0,TERM_SETD);
-        if (psack->itemSz[0] > 0) {
-            printf("\n\titems:\t%s%s",TERM_BOLD,psack->items[0][0]->name);
-            for (i = 1;i < psack->itemSz[0];++i)
-                printf(i%10==0 ? ",\n\t\t%s" : ", %s",psack->items[0][i]->name);
-            printf("%s\n",TERM_SGR0);
-        }
-        else
-            fputc('\n',stdout);
-        if (psack->itemSz[1] > 0) {
-            printf("\tparts:\t%s%s",TERM_BOLD,psack->items[1][0]->name);
-            for (i = 1;i < psack->itemSz[1];++i)
-                printf(i%10==0 ? ",\n\t\t%s" : ", %s",psack->items[1][i]->name);
-            printf("%s\n",TERM_SGR0);
-        }
-    }
+    return strcmp(*left,*right);
 }
-
-/* k_solution */
-struct k_solution* k_solution_new()
+void k_context_print_items(struct k_context* ctx,const char* label,const size_t* ids,size_t cnt)
 {
-    struct k_solution* sol;
-    sol = malloc(sizeof(struct k_solution));
-    if (sol == NULL) {
+    /* print the names of a non-empty list of items in sorted order */
+    size_t i;
+    const char** names;
+    names = malloc(sizeof(const char*) * cnt);
+    if (names == NULL) {
         fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
         exit(EXIT_FAILURE);
     }
-    sol->sackCounter = 0;
-    sol->nodeCounter = 0;
-    sol->sack = NULL;
-    return sol;
-}
-void k_solution_free(struct k_solution* sol)
-{
-    if (sol->sack != NULL)
-        k_sack_free(sol->sack);
-    free(sol);
-}
-int k_solution_check_sack(struct k_solution* sol,struct k_sack* sack)
-{
-    /* see if the sack is better than anything so far */
-    if (sack->cost<=globlInfo.limit && (sol->sack==NULL || sack->value>sol->sack->value)) {
-        if (sol->sack != NULL)
-            k_sack_free(sol->sack);
-        sol->sack = sack;
-        return 1;
-    }
-    return 0;
+    for (i = 0;i < cnt;++i)
+        names[i] = ctx->inst->names[ids[i]];
+    qsort(names,cnt,sizeof(const char*),(int (*)(const void*,const void*))namecompar);
+    fprintf(ctx->out,"\t%s:\t%s%s",label,TERM_BOLD,names[0]);
+    for (i = 1;i < cnt;++i)
+        fprintf(ctx->out,i%10==0 ? ",\n\t\t%s" : ", %s",names[i]);
+    fprintf(ctx->out,"%s\n",TERM_SGR0);
+    free(names);
 }
-void k_solution_print(struct k_solution* sol,const char* title)
+
+void k_context_print_sack(struct k_context* ctx,const struct knapsack_sack* sack,const char* title,size_t leaves,size_t nodes)
 {
-    if (sol->sack==NULL || sol->sack->itemSz==0)
-        printf("\t[%s%s%s%s%s] solution: empty set\n",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD);
+    if (sack->cnt == 0)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] solution: empty set\n",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD);
     else {
-        size_t i;
-        qsort(sol->sack->items,sol->sack->itemSz,sizeof(struct k_item*),(int (*)(const void*,const void*))itemcompar_name);
-        printf("\t[%s%s%s%s%s] solution: cost=%s%s%d%s%s, value=%s%s%d%s%s",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD,
-            TERM_SETF_RED,TERM_BOLD,sol->sack->cost,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,sol->sack->value,TERM_SGR0,TERM_SETD);
-        if (sol->sackCounter > 0)
-            printf(", sack-count=%s%s%zu%s%s",TERM_SETF_RED,TERM_BOLD,sol->sackCounter,TERM_SGR0,TERM_SETD);
-        if (sol->nodeCounter > 0)
-            printf(", node-count=%s%s%zu%s%s",TERM_SETF_RED,TERM_BOLD,sol->nodeCounter,TERM_SGR0,TERM_SETD);
-        printf("\n\titems:\t%s%s",TERM_BOLD,sol->sack->items[0]->name);
-        for (i = 1;i < sol->sack->itemSz;++i)
-            printf(i%10==0 ? ",\n\t\t%s" : ", %s",sol->sack->items[i]->name);
-        printf("%s\n",TERM_SGR0);
+        fprintf(ctx->out,"\t[%s%s%s%s%s] solution: cost=%s%s%d%s%s, value=%s%s%d%s%s",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,sack->cost,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,sack->value,TERM_SGR0,TERM_SETD);
+        if (leaves > 0)
+            fprintf(ctx->out,", sack-count=%s%s%zu%s%s",TERM_SETF_RED,TERM_BOLD,leaves,TERM_SGR0,TERM_SETD);
+        if (nodes > 0)
+            fprintf(ctx->out,", node-count=%s%s%zu%s%s",TERM_SETF_RED,TERM_BOLD,nodes,TERM_SGR0,TERM_SETD);
+        fputc('\n',ctx->out);
+        k_context_print_items(ctx,"items",sack->items,sack->cnt);
     }
 }
 
-/* k_info functionality */
-void k_info_init()
+double elapsed_seconds(const struct timespec* start)
 {
-    globlInfo.lowerValueBound = 0;
-    globlInfo.upperValueBound = 0;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
 }
-void k_info_update_lower_value_bound(struct k_solution* sol)
+static long peak_rss_kb()
 {
-    if (sol->sack->value > globlInfo.lowerValueBound)
-        globlInfo.lowerValueBound = sol->sack->value;
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF,&usage) != 0)
+        return -1;
+    return usage.ru_maxrss;
 }
-
-/* knapsack functionality and utilities */
-static int readline(FILE* fin,char* buf,size_t cap)
+/* statistics records (--stats); one per instance per exact algorithm */
+static const char* const statsFields[] = {
+    "file", "algorithm", "items", "limit", "free_items", "value", "cost", "optimal",
+    "wall_sec", "cpu_sec", "nodes", "nodes_per_sec", "leaves", "cost_prunes", "bound_prunes",
+    "process_peak_rss_kb", "greedy_lower", "partial_upper", "heuristic_lower", "memory_bytes", NULL
+};
+static void knapsack_stats_header()
 {
-    size_t s = --cap;
-    while (cap > 0) {
-        size_t len;
-        if (fgets(buf,cap+1,fin) == NULL)
-            return feof(fin) && cap<s;
-        len = strlen(buf);
-        if (buf[len-1] == '\n') {
-            buf[len-1] = 0;
-            break;
+    size_t i;
+    for (i = 0;statsFields[i] != NULL;++i)
+        printf(i>0 ? ",%s" : "%s",statsFields[i]);
+    putchar('\n');
+}
+static void knapsack_stats_string(FILE* out,const char* str)
+{
+    /* quote a string for JSON or CSV */
+    const char* p;
+    fputc('"',out);
+    for (p = str;*p;++p) {
+        if (globlOptions.stats == K_STATS_CSV) {
+            if (*p == '"')
+                fputc('"',out);
+            fputc(*p,out);
         }
-        buf += len;
-        cap -= len;
+        else if (*p=='"' || *p=='\\')
+            fprintf(out,"\\%c",*p);
+        else if ((unsigned char)*p < 0x20)
+            fprintf(out,"\\u%04x",(unsigned)*p);
+        else
+            fputc(*p,out);
     }
-    return 1;
-}
-static char* commasep(char** s)
-{
-    char* i, *start;
-    while ( isspace(**s) )
-        ++*s;
-    start = *s;
-    while (**s && **s!=',')
-        ++*s;
-    i = *s-1;
-    while ( isspace(*i) )
-        *(i--) = 0;
-    **s = 0;
-    ++*s;
-    return start;
+    fputc('"',out);
 }
-void knapsack(FILE* fin,const char* filename)
+static void knapsack_stats_record(struct k_context* ctx,const char* algorithm,const struct knapsack_result* result,const struct knapsack_bounds* bounds)
 {
+    /* 'bounds' is NULL for the parametric mode, which computes none */
     size_t i;
-    char linebuf[4097];
-    size_t itemCap, itemSz;
-    struct k_item** items;
-    struct k_solution* solution;
-    struct k_partial_sack* partial;
-    k_info_init();
-    /* read in knapsack limit */
-    readline(fin,linebuf,sizeof(linebuf));
-    if (sscanf(linebuf,"%d",&globlInfo.limit) != 1) {
-        fprintf(stderr,"%s: format error in file '%s': <cost-limit> field was not an integer\n",programName,filename);
-        return;
-    }
-    /* read in set of possible items */
-    itemCap = 4;
-    itemSz = 0;
-    items = malloc(sizeof(struct k_item*) * itemCap);
-    if (items == NULL) {
-        fprintf(stderr,"%s: memory exception: fail malloc()\n",programName);
-        exit(EXIT_FAILURE);
-    }
-    while (1) {
-        if (itemSz >= itemCap) {
-            struct k_item** newblock;
-            itemCap <<= 1;
-            newblock = realloc(items,sizeof(struct k_item*) * itemCap);
-            if (newblock == NULL) {
-                fprintf(stderr,"%s: memory exception: fail realloc()\n",programName);
-                exit(EXIT_FAILURE);
-            }
-            items = newblock;
-        }
-        if ( readline(fin,linebuf,sizeof(linebuf)) ) {
-            char* s, *name;
-            int cost, value;
-            s = linebuf;
-            name = commasep(&s);
-            if (sscanf(commasep(&s),"%d",&cost)!=1 || sscanf(commasep(&s),"%d",&value)!=1) {
-                fprintf(stderr,"%s: format error in file '%s': bad item format for item %d\n",programName,filename,(int)itemSz+1);
-                free(items);
-                return;
-            }
-            items[itemSz++] = k_item_new(cost,value,name);
-        }
-        else {
-            items[itemSz] = NULL;
-            break;
-        }
+    FILE* out = ctx->stats;
+    char values[18][64];
+    /* everything but the two strings is a number */
+    snprintf(values[0],64,"%zu",ctx->inst->count);
+    snprintf(values[1],64,"%d",result->limit);
+    snprintf(values[2],64,"%zu",result->freeCnt);
+    snprintf(values[3],64,"%d",result->sack.value);
+    snprintf(values[4],64,"%d",result->sack.cost);
+    snprintf(values[5],64,"%d",result->optimal);
+    snprintf(values[6],64,"%.6f",result->wallSeconds);
+    snprintf(values[7],64,"%.6f",result->cpuSeconds);
+    snprintf(values[8],64,"%zu",result->nodes);
+    snprintf(values[9],64,"%.0f",result->wallSeconds>0.0 ? result->nodes/result->wallSeconds : 0.0);
+    snprintf(values[10],64,"%zu",result->leaves);
+    snprintf(values[11],64,"%zu",result->costPrunes);
+    snprintf(values[12],64,"%zu",result->boundPrunes);
+    /* the peak of the whole process, all -j instances included */
+    snprintf(values[13],64,"%ld",peak_rss_kb());
+    snprintf(values[14],64,"%d",bounds!=NULL ? bounds->greedyLower : 0);
+    snprintf(values[15],64,"%d",bounds!=NULL ? bounds->upper : 0);
+    snprintf(values[16],64,"%d",bounds!=NULL ? bounds->lower : 0);
+    snprintf(values[17],64,"%zu",result->memory);
+    if (globlOptions.stats == K_STATS_JSON) {
+        fprintf(out,"{\"%s\": ",statsFields[0]);
+        knapsack_stats_string(out,ctx->filename);
+        fprintf(out,", \"%s\": ",statsFields[1]);
+        knapsack_stats_string(out,algorithm);
+        for (i = 0;i < 18;++i)
+            fprintf(out,", \"%s\": %s",statsFields[i+2],i==5 ? (values[i][0]=='1' ? "true" : "false") : values[i]);
+        fputs("}\n",out);
     }
-    if (itemSz <= 0) {
-        fprintf(stderr,"%s: empty item set in file '%s'\n",programName,filename);
-        free(items);
-        return;
+    else {
+        knapsack_stats_string(out,ctx->filename);
+        fputc(',',out);
+        knapsack_stats_string(out,algorithm);
+        for (i = 0;i < 18;++i)
+            fprintf(out,",%s",values[i]);
+        fputc('\n',out);
     }
-    printf("[%s%s%s%s%s] with item-count=%s%s%zu%s%s and cost-limit=%s%s%d%s%s\n",TERM_SETF_BLUE,TERM_BOLD,filename,TERM_SGR0,TERM_SETD,
-        TERM_SETF_RED,TERM_BOLD,itemSz,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,globlInfo.limit,TERM_SGR0,TERM_SETD);
-    /* produce alternate solutions (greedy and partial); use these to
-       compute lower and upper bounds on the best sack */
-    solution = greedy_highest_value(items,itemSz);
-    k_solution_print(solution,"greedy/highest value");
-    k_info_update_lower_value_bound(solution);
-    k_solution_free(solution);
-    solution = greedy_lowest_cost(items,itemSz);
-    k_solution_print(solution,"greedy/lowest cost");
-    k_info_update_lower_value_bound(solution);
-    k_solution_free(solution);
-    solution = greedy_highest_ratio(items,itemSz);
-    k_solution_print(solution,"greedy/highest ratio");
-    k_info_update_lower_value_bound(solution);
-    k_solution_free(solution);
-    partial = partial_knapsack(items,itemSz);
-    k_partial_sack_print(partial,"partial knapsack");
-    k_partial_sack_free(partial);
-    goto skip;
-    /* do an exhaustive search that optimizes out sub-trees that exceed cost limit */
-    globlSolution = k_solution_new();
-    knapsack_optimized1_recursive(items,k_sack_new());
-    k_solution_print(globlSolution,"optimized1");
-    k_solution_free(globlSolution);
-    /* do an exhaustive search that optimizes out sub-trees whose value does not reach
-       the lower value bound; this optimization is performed in addition to the one above */
-    globlSolution = k_solution_new();
-    knapsack_optimized2_recursive(items,k_sack_new());
-    k_solution_print(globlSolution,"optimized2");
-    k_solution_free(globlSolution);
-skip:
-    /* do the best optimization of exhaustive search; this is like the above but better */
-    globlSolution = k_solution_new();
-    knapsack_optimized3(items);
-    k_solution_print(globlSolution,"optimized");
-    k_solution_free(globlSolution);
-    /* do a brute-force exhaustive search that explores all of the candidate
-       solutions; the k_solution will find the best sack as it generates them */
-    globlSolution = k_solution_new();
-    knapsack_bruteforce_recursive(items,k_sack_new());
-    k_solution_print(globlSolution,"brute force");
-    k_solution_free(globlSolution);
-    for (i = 0;i < itemSz;++i)
-        k_item_free(items[i]);
-    free(items);
 }
-void knapsack_bruteforce_recursive(struct k_item** item,struct k_sack* sack)
+
+/* knapsack functionality */
+static void knapsack_print_incumbent(void* arg,int value,int upper,double seconds)
 {
-    struct k_sack* right;
-    ++globlSolution->nodeCounter;
-    if (*item == NULL) {
-        ++globlSolution->sackCounter;
-        /* sack is a leaf sack; check it to see if it is a better
-           solution; if not, then delete it */
-        if (!k_solution_check_sack(globlSolution,sack))
-            k_sack_free(sack);
-        return;
-    }
-    right = k_sack_copy(sack);
-    /* generate subtree that does not contain the current item */
-    knapsack_bruteforce_recursive(item+1,sack);
-    /* generate the subtree that contains the current item */
-    k_sack_add_item(right,*item);
-    knapsack_bruteforce_recursive(item+1,right);
+    /* anytime mode: report each new best sack along with how far it may still
+       be from the LP bound of the instance */
+    struct k_context* ctx = arg;
+    fprintf(ctx->out,"\t\t[incumbent] value=%s%s%d%s%s, elapsed=%.6f sec, upper=%d, gap=%d (%.2f%%)\n",TERM_SETF_RED,TERM_BOLD,value,TERM_SGR0,TERM_SETD,
+        seconds,upper,upper-value,upper>0 ? 100.0*(upper-value)/upper : 0.0);
 }
-void knapsack_optimized1_recursive(struct k_item** item,struct k_sack* sack)
+static void knapsack_print_anytime_status(struct k_context* ctx,const struct knapsack_result* result,const char* title)
 {
-    struct k_sack* right;
-    ++globlSolution->nodeCounter;
-    if (*item == NULL) {
-        ++globlSolution->sackCounter;
-        if (!k_solution_check_sack(globlSolution,sack))
-            k_sack_free(sack);
+    int value = result->sack.value, upper = result->upper;
+    if (result->optimal) {
+        fprintf(ctx->out,"\t[%s%s%s%s%s] proven optimal in %.6f sec\n",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD,result->wallSeconds);
         return;
     }
-    right = k_sack_copy(sack);
-    k_sack_add_item(right,*item);
-    knapsack_optimized1_recursive(item+1,right);
-    if (sack->cost <= globlInfo.limit)
-        knapsack_optimized1_recursive(item+1,sack);
-    else
-        k_sack_free(sack);
+    fprintf(ctx->out,"\t[%s%s%s%s%s] stopped at time limit after %.6f sec: value=%d, upper=%d, gap=%s%s%d%s%s (%.2f%%), %s\n",TERM_SETF_BLUE,TERM_BOLD,title,TERM_SGR0,TERM_SETD,
+        result->wallSeconds,value,upper,TERM_SETF_RED,TERM_BOLD,upper-value,TERM_SGR0,TERM_SETD,upper>0 ? 100.0*(upper-value)/upper : 0.0,
+        upper==value ? "proven optimal" : "not proven optimal");
 }
-int knapsack_optimized2_recursive(struct k_item** item,struct k_sack* sack)
+static void knapsack_print_details(struct k_context* ctx,const struct knapsack_result* result)
 {
-    struct k_sack* right;
-    ++globlSolution->nodeCounter;
-    if (*item == NULL) {
-        ++globlSolution->sackCounter;
-        if (sack->value < globlInfo.lowerValueBound) {
-            k_sack_free(sack);
-            return 0;
+    /* the extra report lines of the parallel, best-first, subset-sum, FPTAS and meet in the middle searches */
+    size_t i;
+    double rate;
+    if (result->algorithm == KNAPSACK_PARALLEL) {
+        rate = 0.0;
+        for (i = 0;i < result->threads;++i)
+            if (result->threadStats[i].seconds > 0.0)
+                rate += result->threadStats[i].nodes / result->threadStats[i].seconds;
+        fprintf(ctx->out,"\t[%s%s%s%s%s] threads=%s%s%zu%s%s, split-depth=%s%s%zu%s%s, tasks=%s%s%zu%s%s, nodes/sec=%s%s%.0f%s%s (%.0f summed over threads)\n",
+            TERM_SETF_BLUE,TERM_BOLD,"parallel optimized",TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,result->threads,TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,result->splitDepth,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,result->tasks,TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,result->wallSeconds>0.0 ? result->nodes/result->wallSeconds : 0.0,TERM_SGR0,TERM_SETD,rate);
+        for (i = 0;i < result->threads;++i) {
+            const struct knapsack_thread_stats* thread = result->threadStats + i;
+            fprintf(ctx->out,"\t\tthread %zu: tasks=%zu, steals=%zu, node-count=%zu, nodes/sec=%.0f\n",i,thread->tasks,thread->steals,
+                thread->nodes,thread->seconds>0.0 ? thread->nodes/thread->seconds : 0.0);
         }
-        if (!k_solution_check_sack(globlSolution,sack))
-            k_sack_free(sack);
-        return 1;
-    }
-    right = k_sack_copy(sack);
-    k_sack_add_item(right,*item);
-    if (!knapsack_optimized2_recursive(item+1,right)) {
-        k_sack_free(sack);
-        return 0;
     }
-    if (sack->cost <= globlInfo.limit)
-        knapsack_optimized2_recursive(item+1,sack);
-    else
-        k_sack_free(sack);
-    return 1;
-}
-static void knapsack_optimized3_recursive(struct k_item** item,struct k_sack* sack,int potential)
-{
-    ++globlSolution->nodeCounter;
-    if (*item == NULL) {
-        ++globlSolution->sackCounter;
-        if (!k_solution_check_sack(globlSolution,sack))
-            k_sack_free(sack);
+    else if (result->algorithm == KNAPSACK_BEST_FIRST)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] expanded=%s%s%zu%s%s, peak-queue=%s%s%zu%s%s, memory=%zu bytes, depth-first-subtrees=%zu\n",TERM_SETF_BLUE,TERM_BOLD,"best-first",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,result->expanded,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,result->peakQueue,TERM_SGR0,TERM_SETD,result->memory,result->fallbacks);
+    else if (result->algorithm==KNAPSACK_DP && result->subsetSum)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] subset-sum instance: bitset of reachable sums, memory=%s%s%zu bytes%s%s\n",TERM_SETF_BLUE,TERM_BOLD,"dynamic programming",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,result->memory,TERM_SGR0,TERM_SETD);
+    else if (result->algorithm == KNAPSACK_FPTAS)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] epsilon=%g, scale=%s%s%g%s%s: value=%d, upper=%d, gap=%s%s%d%s%s (%.2f%%), %s, memory=%zu bytes\n",TERM_SETF_BLUE,TERM_BOLD,"fptas",TERM_SGR0,TERM_SETD,
+            result->epsilon,TERM_SETF_RED,TERM_BOLD,result->scale,TERM_SGR0,TERM_SETD,result->sack.value,result->upper,TERM_SETF_RED,TERM_BOLD,result->upper-result->sack.value,TERM_SGR0,TERM_SETD,
+            result->upper>0 ? 100.0*(result->upper-result->sack.value)/result->upper : 0.0,result->optimal ? "proven optimal" : "within (1-epsilon) of the optimum",result->memory);
+    else if (result->algorithm == KNAPSACK_MITM)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] pareto-subsets=%s%s%zu+%zu%s%s, memory=%s%s%zu bytes%s%s\n",TERM_SETF_BLUE,TERM_BOLD,"meet in the middle",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,result->paretoCnt[0],result->paretoCnt[1],TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,result->memory,TERM_SGR0,TERM_SETD);
+}
+void knapsack(struct k_context* ctx,const char* path)
+{
+    int i, status;
+    char err[512];
+    struct kinst* inst;
+    struct knapsack_options opts;
+    struct knapsack_problem* problem;
+    const struct knapsack_bounds* bounds;
+    static const char* const greedyTitles[KNAPSACK_GREEDY_COUNT] = {
+        "greedy/highest value", "greedy/lowest cost", "greedy/highest ratio"
+    };
+    /* load the instance; the item arrays and names are left in the loader's
+       buffer so the instance must outlive the problem */
+    inst = kinst_load(path,ctx->filename,err,sizeof(err));
+    if (inst == NULL) {
+        fprintf(stderr,"%s: %s\n",programName,err);
         return;
     }
-    if (potential>=globlInfo.lowerValueBound && sack->cost<=globlInfo.limit) {
-        struct k_sack* right;
-        right = k_sack_copy(sack);
-        k_sack_add_item(right,*item);
-        knapsack_optimized3_recursive(item+1,right,potential);
-        knapsack_optimized3_recursive(item+1,sack,potential - (*item)->value);
-    }
-    else
-        k_sack_free(sack);
-}
-void knapsack_optimized3(struct k_item** item)
-{
-    int sum = 0;
-    struct k_item** iter = item;
-    while (*iter != NULL) {
-        sum += (*iter)->value;
-        ++iter;
-    }
-    knapsack_optimized3_recursive(item,k_sack_new(),sum);
-}
-struct k_solution* greedy_highest_value(struct k_item** items,size_t cnt)
-{
-    size_t iter;
-    int leftover;
-    struct k_solution* solution;
-    qsort(items,cnt,sizeof(struct k_item*),(int (*)(const void*,const void*))itemcompar_value);
-    solution = k_solution_new();
-    solution->sack = k_sack_new();
-    leftover = globlInfo.limit;
-    for (iter = 0;iter < cnt;++iter) {
-        if (items[iter]->cost <= leftover) {
-            k_sack_add_item(solution->sack,items[iter]);
-            leftover -= items[iter]->cost;
-        }
+    if (inst->count <= 0) {
+        fprintf(stderr,"%s: empty item set in file '%s'\n",programName,ctx->filename);
+        kinst_free(inst);
+        return;
     }
-    return solution;
-}
-struct k_solution* greedy_lowest_cost(struct k_item** items,size_t cnt)
-{
-    size_t iter;
-    int leftover;
-    struct k_solution* solution;
-    qsort(items,cnt,sizeof(struct k_item*),(int (*)(const void*,const void*))itemcompar_cost);
-    solution = k_solution_new();
-    solution->sack = k_sack_new();
-    leftover = globlInfo.limit;
-    for (iter = 0;iter < cnt;++iter) {
-        if (items[iter]->cost <= leftover) {
-            k_sack_add_item(solution->sack,items[iter]);
-            leftover -= items[iter]->cost;
+    ctx->inst = inst;
+    fprintf(ctx->out,"[%s%s%s%s%s] with item-count=%s%s%zu%s%s and cost-limit=%s%s%d%s%s\n",TERM_SETF_BLUE,TERM_BOLD,ctx->filename,TERM_SGR0,TERM_SETD,
+        TERM_SETF_RED,TERM_BOLD,inst->count,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,inst->limit,TERM_SGR0,TERM_SETD);
+    fprintf(ctx->out,"\tparsed %zu bytes of %s in %.6f seconds (%.1f MB/s, %s)\n",inst->bytes,
+        inst->format==KINST_FORMAT_BINARY ? "binary" : "csv",inst->seconds,kinst_throughput(inst),inst->mapped ? "mapped" : "buffered");
+    if (globlOptions.limitCnt == 0) {
+        /* the root bound in linear time, before the items are sorted */
+        size_t critical;
+        double bound, seconds;
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        bound = knapsack_lp_bound(inst->cost,inst->value,inst->count,inst->limit,&critical);
+        seconds = elapsed_seconds(&start);
+        if (bound < 0.0) {
+            fprintf(stderr,"%s: %s: out of memory\n",programName,ctx->filename);
+            __atomic_store_n(&exitStatus,EXIT_FAILURE,__ATOMIC_RELAXED);
+            ctx->inst = NULL;
+            kinst_free(inst);
+            return;
         }
+        fprintf(ctx->out,"\t[%s%s%s%s%s] bound=%s%s%f%s%s, critical=%s, time=%.6f sec\n",TERM_SETF_BLUE,TERM_BOLD,"critical item",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,bound,TERM_SGR0,TERM_SETD,critical<inst->count ? inst->names[critical] : "none",seconds);
+        fflush(ctx->out);
+    }
+    opts = globlOptions.solver;
+    if (globlOptions.limitCnt > 0)
+        /* the bounds are not used by the parametric mode */
+        opts.reduce = opts.localSearch = 0;
+    if (opts.timeLimit > 0.0) {
+        opts.incumbent = knapsack_print_incumbent;
+        opts.arg = ctx;
+    }
+    problem = knapsack_problem_new(inst->cost,inst->value,inst->count,inst->limit,&opts);
+    if (problem == NULL) {
+        size_t j;
+        for (j = 0;j<inst->count && inst->cost[j]>=0 && inst->value[j]>=0;++j)
+            ;
+        if (j < inst->count)
+            fprintf(stderr,"%s: %s: item '%s' has a negative cost or value\n",programName,ctx->filename,inst->names[j]);
         else
-            /* all the remaining items could never fit */
-            break;
+            fprintf(stderr,"%s: %s: out of memory\n",programName,ctx->filename);
+        __atomic_store_n(&exitStatus,EXIT_FAILURE,__ATOMIC_RELAXED);
+        ctx->inst = NULL;
+        kinst_free(inst);
+        return;
     }
-    return solution;
-}
-struct k_solution* greedy_highest_ratio(struct k_item** items,size_t cnt)
-{
-    size_t iter;
-    int leftover;
-    struct k_solution* solution;
-    qsort(items,cnt,sizeof(struct k_item*),(int (*)(const void*,const void*))itemcompar_ratio);
-    solution = k_solution_new();
-    solution->sack = k_sack_new();
-    leftover = globlInfo.limit;
-    for (iter = 0;iter < cnt;++iter) {
-        if (items[iter]->cost <= leftover) {
-            k_sack_add_item(solution->sack,items[iter]);
-            leftover -= items[iter]->cost;
-        }
+    if (globlOptions.limitCnt > 0) {
+        /* parametric mode answers the --limits queries instead of the file's
+           own cost limit */
+        knapsack_limits(ctx,problem);
+        knapsack_problem_free(problem);
+        ctx->inst = NULL;
+        kinst_free(inst);
+        return;
     }
-    return solution;
-}
-struct k_partial_sack* partial_knapsack(struct k_item** items,size_t cnt)
-{
-    size_t iter;
-    int leftover;
-    struct k_partial_sack* sack;
-    qsort(items,cnt,sizeof(struct k_item*),(int (*)(const void*,const void*))itemcompar_ratio);
-    sack = k_partial_sack_new();
-    leftover = globlInfo.limit;
-    for (iter = 0;iter < cnt;++iter) {
-        int cost = items[iter]->cost > leftover ? leftover : items[iter]->cost;
-        k_partial_sack_add_item(sack,items[iter],cost);
-        if ((leftover-=cost) <= 0)
-            break;
+    /* the alternate solutions (greedy and partial) that give the lower and
+       upper bounds on the best sack */
+    bounds = knapsack_problem_bounds(problem);
+    for (i = 0;i < KNAPSACK_GREEDY_COUNT;++i)
+        k_context_print_sack(ctx,bounds->greedy+i,greedyTitles[i],0,0);
+    if (opts.localSearch) {
+        k_context_print_sack(ctx,&bounds->local,"local search",0,0);
+        /* the nodes this saves are measured against a --no-local-search run */
+        fprintf(ctx->out,"\t[%s%s%s%s%s] lower bound %d -> %s%s%d%s%s (+%d), moves=%zu, time=%.6f sec\n",TERM_SETF_BLUE,TERM_BOLD,"local search",TERM_SGR0,TERM_SETD,
+            bounds->greedyLower,TERM_SETF_RED,TERM_BOLD,bounds->lower,TERM_SGR0,TERM_SETD,bounds->lower-bounds->greedyLower,bounds->localMoves,bounds->localSeconds);
+    }
+    if (bounds->partialCnt==0 && bounds->partCnt==0)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] solution: empty set\n",TERM_SETF_BLUE,TERM_BOLD,"partial knapsack",TERM_SGR0,TERM_SETD);
+    else {
+        fprintf(ctx->out,"\t[%s%s%s%s%s] solution: cost=%s%s%d%s%s, value=%s%s%f%s%s\n",TERM_SETF_BLUE,TERM_BOLD,"partial knapsack",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,bounds->partialCost,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,bounds->partialValue,TERM_SGR0,TERM_SETD);
+        if (bounds->partialCnt > 0)
+            k_context_print_items(ctx,"items",bounds->partialItems,bounds->partialCnt);
+        if (bounds->partCnt > 0)
+            k_context_print_items(ctx,"parts",bounds->partItems,bounds->partCnt);
+    }
+    if (opts.reduce)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] fixed=%s%s%zu%s%s (in=%zu, out=%zu), free-count=%s%s%zu%s%s, time=%.6f sec\n",TERM_SETF_BLUE,TERM_BOLD,"reduction",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,inst->count-bounds->freeCnt,TERM_SGR0,TERM_SETD,bounds->fixedIn,bounds->fixedOut,
+            TERM_SETF_RED,TERM_BOLD,bounds->freeCnt,TERM_SGR0,TERM_SETD,bounds->reduceSeconds);
+    if (opts.collapse && bounds->classCnt<bounds->freeCnt)
+        fprintf(ctx->out,"\t[%s%s%s%s%s] classes=%s%s%zu%s%s of identical items among %zu free items\n",TERM_SETF_BLUE,TERM_BOLD,"collapse",TERM_SGR0,TERM_SETD,
+            TERM_SETF_RED,TERM_BOLD,bounds->classCnt,TERM_SGR0,TERM_SETD,bounds->freeCnt);
+    /* run each of the selected exact algorithms */
+    for (i = 0;i < KNAPSACK_ALGORITHM_COUNT;++i) {
+        struct knapsack_result result;
+        const char* title = knapsack_algorithm_title(i);
+        if ( !globlOptions.algorithms[i] )
+            continue;
+        if ((status = knapsack_solve(problem,i,&result)) < 0) {
+            /* no sack was found, so there is nothing to report or record */
+            if (status == KNAPSACK_NO_MEMORY)
+                fprintf(stderr,"%s: %s: algorithm '%s' ran out of memory\n",programName,ctx->filename,knapsack_algorithm_name(i));
+            else if (i == KNAPSACK_MITM)
+                fprintf(stderr,"%s: %s: meet in the middle supports at most %d free items\n",programName,ctx->filename,KNAPSACK_MITM_MAX_ITEMS);
+            else
+                fprintf(stderr,"%s: %s: algorithm '%s' cannot solve the instance\n",programName,ctx->filename,knapsack_algorithm_name(i));
+            __atomic_store_n(&exitStatus,EXIT_FAILURE,__ATOMIC_RELAXED);
+            knapsack_result_destroy(&result);
+            continue;
+        }
+        knapsack_print_details(ctx,&result);
+        k_context_print_sack(ctx,&result.sack,title,result.leaves,result.nodes);
+        if (opts.timeLimit>0.0 && i!=KNAPSACK_FPTAS)
+            knapsack_print_anytime_status(ctx,&result,title);
+        if (ctx->stats != NULL)
+            knapsack_stats_record(ctx,knapsack_algorithm_name(i),&result,bounds);
+        knapsack_result_destroy(&result);
+    }
+    knapsack_problem_free(problem);
+    ctx->inst = NULL;
+    kinst_free(inst);
+}
+void knapsack_limits(struct k_context* ctx,const struct knapsack_problem* problem)
+{
+    size_t q;
+    char title[32];
+    struct knapsack_limits limits;
+    if (knapsack_solve_limits(problem,globlOptions.limits,globlOptions.limitCnt,&limits) < 0) {
+        fprintf(stderr,"%s: %s: parametric dp ran out of memory\n",programName,ctx->filename);
+        __atomic_store_n(&exitStatus,EXIT_FAILURE,__ATOMIC_RELAXED);
+        return;
     }
-    return sack;
+    fprintf(ctx->out,"\t[%s%s%s%s%s] limits=%s%s%zu%s%s, max-limit=%s%s%d%s%s, items=%s%s%zu%s%s, table=%.1f MB%s, pass=%.6f sec\n",
+        TERM_SETF_BLUE,TERM_BOLD,"parametric dp",TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,limits.cnt,TERM_SGR0,TERM_SETD,
+        TERM_SETF_RED,TERM_BOLD,limits.maxLimit,TERM_SGR0,TERM_SETD,TERM_SETF_RED,TERM_BOLD,limits.itemCnt,TERM_SGR0,TERM_SETD,
+        limits.tableBytes/1e6,limits.tableBytes>0 ? "" : " (rebuilding by divide-and-conquer)",limits.passSeconds);
+    for (q = 0;q < limits.cnt;++q) {
+        const struct knapsack_result* result = limits.results + q;
+        snprintf(title,sizeof(title),"limit=%d",result->limit);
+        k_context_print_sack(ctx,&result->sack,title,0,0);
+        if (ctx->stats != NULL)
+            knapsack_stats_record(ctx,"limits",result,NULL);
+    }
+    knapsack_limits_destroy(&limits);
 }
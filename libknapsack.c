@@ -0,0 +1,3039 @@
+/* libknapsack.c - solvers for the 0/1 knapsack problem (see knapsack.h); the
+   knapsack program (knapsack2.c) is a front end to them */
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "knapsack.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+struct k_context;
+
+/* nothing here ends the process when memory runs out: the functions that
+   allocate return NULL or zero and leave their arguments as they were, and
+   an algorithm that cannot go on sets ctx->failed so that knapsack_solve()
+   can return KNAPSACK_NO_MEMORY */
+
+/* the items of a problem stored as parallel arrays; an item is referred to by
+   its index (id) into the arrays */
+struct k_items
+{
+    size_t cnt;
+    const int* cost;
+    const int* value;
+    double* ratio; /* value/cost */
+    /* item ids in order of decreasing value, increasing cost and decreasing
+       value/cost ratio */
+    size_t* byValue;
+    size_t* byCost;
+    size_t* byRatio;
+};
+static int k_items_init(struct k_items* items,const int* cost,const int* value,size_t cnt);
+static void k_items_destroy(struct k_items* items);
+
+/* an ordered subset of the items that the exact algorithms run on; each item's
+   cost and value are copied next to its id so that the search loops read
+   contiguous arrays */
+struct k_set
+{
+    size_t cnt;
+    size_t* id;
+    int* cost;
+    int* value;
+};
+static int k_set_init(struct k_set* set,size_t cap);
+static void k_set_destroy(struct k_set* set);
+static inline void k_set_add(struct k_set* set,size_t id,int cost,int value);
+static int k_set_order(struct k_set* set,const struct k_items* items,const size_t* order);
+static size_t* k_set_classes(struct k_set* set);
+
+struct k_sack
+{
+    int cost;
+    int value;
+    size_t itemCap, itemSz;
+    size_t* items; /* item ids */
+};
+static struct k_sack* k_sack_new();
+static void k_sack_free(struct k_sack* sack);
+static int k_sack_add_item(struct k_sack* sack,size_t id,int cost,int value);
+static void k_sack_release(struct k_sack* sack,struct knapsack_sack* out);
+
+struct k_partial_sack
+{
+    int cost;
+    double value; /* needs fractional component */
+    /* items[0] are complete items; items[1] are partial */
+    size_t itemCap[2], itemSz[2];
+    size_t* items[2];
+};
+static struct k_partial_sack* k_partial_sack_new();
+static int k_partial_sack_add_item(struct k_partial_sack* psack,const struct k_items* items,size_t id,int cost);
+static void k_partial_sack_free(struct k_partial_sack* psack);
+
+struct k_solution
+{
+    size_t sackCounter; /* number of sacks considered before solution */
+    size_t nodeCounter; /* number of potential nodes processed during a solution run */
+    size_t costPrunes; /* subtrees cut because the sack was over the cost limit */
+    size_t boundPrunes; /* subtrees cut because they could not beat the value bound */
+    double cpuSeconds; /* CPU time of any helper threads */
+    struct k_sack* sack; /* solution knapsack */
+};
+static struct k_solution* k_solution_new();
+static void k_solution_free(struct k_solution* sol);
+static int k_solution_check_sack(struct k_context* ctx,struct k_solution* sol,struct k_sack* sack);
+
+struct k_info
+{
+    int limit; /* total cost that must not be exceeded */
+    int lowerValueBound; /* value of best greedy knapsack */
+    int upperValueBound; /* value of best partial knapsack */
+};
+static void k_info_init(struct k_info* info);
+static inline int k_info_update_lower_value_bound(struct k_info* info,struct k_solution* sol);
+
+/* the state of one run of an algorithm; each knapsack_solve() call has its
+   own, so a problem can be solved from several threads at once */
+struct k_context
+{
+    const struct k_items* items;
+    const struct knapsack_options* opts;
+    struct k_info info; /* lowerValueBound is shared between search threads */
+    struct k_solution* solution; /* solution of the exact algorithm being run */
+    struct knapsack_result* result; /* receives the details of the parallel, best-first and meet in the middle runs */
+    /* anytime state of the exact algorithm being run (see timeLimit) */
+    struct timespec start;
+    int fixedValue; /* value of the items fixed by the reduction */
+    int timedOut; /* set once the time limit has passed */
+    int openBound; /* best upper bound of the subtrees abandoned at the time limit */
+    int failed; /* set once an allocation has failed */
+    /* classEnd[i] is the position in the search's set after the class of
+       items identical to item i; NULL unless the search collapses them */
+    size_t* classEnd;
+};
+static inline size_t k_context_next(const struct k_context* ctx,size_t index);
+static void k_context_collapse(struct k_context* ctx,struct k_set* set);
+static inline void k_context_fail(struct k_context* ctx);
+
+/* a problem as built by knapsack_problem_new() */
+struct knapsack_problem
+{
+    int limit;
+    struct knapsack_options opts;
+    struct k_items items;
+    struct knapsack_bounds bounds;
+    struct k_set freeItems; /* items left after the reduction, in ratio order */
+    struct k_sack* fixed; /* items fixed into every optimal sack */
+    const struct knapsack_sack* heuristic; /* best sack of the heuristics or NULL if all are empty */
+};
+
+/* prefix sums of cost and value over a ratio-sorted item set; these give the
+   fractional (Dantzig) upper bound of any suffix of the set in O(log n) by
+   binary searching for the critical item */
+struct k_bound_table
+{
+    const struct k_set* set;
+    long long* cost; /* cost[i] is the total cost of items 0..i-1 of the set */
+    long long* value; /* value[i] is the total value of items 0..i-1 of the set */
+};
+static int k_bound_table_init(struct k_bound_table* table,const struct k_set* set);
+static void k_bound_table_destroy(struct k_bound_table* table);
+static int k_bound_table_upper(const struct k_bound_table* table,size_t index,int capacity);
+
+struct k_worker;
+
+/* a call of the depth-first searches, which run on an explicit stack of frames
+   instead of recursing; 'stage' is how far the node has got with its children */
+struct k_frame
+{
+    size_t index;
+    int stage;
+};
+
+/* allocation-free depth-first search state: the positions in the set of the
+   items included along the current path live on a stack that is pushed/popped
+   as the search descends and backtracks; a sack is only built when a leaf
+   improves the solution */
+struct k_search
+{
+    int cost;
+    int value;
+    size_t depth;
+    size_t* stack;
+    struct k_frame* frames; /* one per item and one for the leaf */
+    const struct k_set* set;
+    struct k_context* ctx;
+    struct k_solution* sol;
+    const struct k_bound_table* bound; /* upper bounds for the remaining items */
+    struct k_worker* worker; /* set if the search runs on a parallel search thread */
+    unsigned clockCheck; /* nodes left until the clock is read again */
+    int openBound; /* best upper bound of the subtrees abandoned at the time limit */
+};
+enum k_search_constants
+{
+    K_CLOCK_CHECK_NODES = 4096
+};
+static int k_search_init(struct k_search* search,const struct k_set* set,struct k_context* ctx,struct k_solution* sol);
+static void k_search_destroy(struct k_search* search);
+static inline void k_search_push(struct k_search* search,size_t index);
+static inline void k_search_pop(struct k_search* search);
+static int k_search_check_leaf(struct k_search* search);
+static inline int k_search_cut(struct k_search* search,size_t index);
+static inline int k_search_expired(struct k_search* search,size_t index);
+static int knapsack_parallel_donate(struct k_search* search,size_t index);
+
+/* solution functionality */
+static void knapsack_bruteforce_search(struct k_search* search);
+static void knapsack_optimized1_search(struct k_search* search);
+static void knapsack_optimized2_search(struct k_search* search);
+static void knapsack_optimized3_search(struct k_search* search,size_t index);
+static void knapsack_bruteforce(struct k_context* ctx,struct k_set* set);
+static void knapsack_optimized1(struct k_context* ctx,struct k_set* set);
+static void knapsack_optimized2(struct k_context* ctx,struct k_set* set);
+static void knapsack_optimized3(struct k_context* ctx,struct k_set* set);
+static void knapsack_dynamic(struct k_context* ctx,struct k_set* set);
+static void knapsack_fptas(struct k_context* ctx,struct k_set* set);
+static void knapsack_meet_in_the_middle(struct k_context* ctx,struct k_set* set);
+static void knapsack_parallel(struct k_context* ctx,struct k_set* set);
+static void knapsack_best_first(struct k_context* ctx,struct k_set* set);
+static struct k_sack* greedy(const struct k_items* items,const size_t* order,int limit,int stop);
+static struct k_partial_sack* partial_knapsack(const struct k_items* items,int limit);
+static struct k_sack* local_search(const struct k_items* items,const struct knapsack_sack* start,int limit,size_t* moves);
+static int knapsack_reduce(struct knapsack_problem* problem);
+static double elapsed_seconds(const struct timespec* start);
+static double cpu_seconds();
+
+/* the exact algorithms in knapsack_algorithm order; each one leaves its result
+   in ctx->solution */
+struct k_algorithm
+{
+    const char* name; /* command-line name */
+    const char* title; /* title for printing the solution */
+    void (*solve)(struct k_context* ctx,struct k_set* set);
+};
+static const struct k_algorithm algorithms[] = {
+    {"optimized1", "optimized1", knapsack_optimized1},
+    {"optimized2", "optimized2", knapsack_optimized2},
+    {"optimized", "optimized", knapsack_optimized3},
+    {"parallel", "parallel optimized", knapsack_parallel},
+    {"best-first", "best-first", knapsack_best_first},
+    {"dp", "dynamic programming", knapsack_dynamic},
+    {"fptas", "fptas", knapsack_fptas},
+    {"mitm", "meet in the middle", knapsack_meet_in_the_middle},
+    {"bruteforce", "brute force", knapsack_bruteforce}
+};
+
+/* k_items */
+/* the orders are built by LSD radix sort over integer keys computed once per
+   item: ints are mapped to unsigned keys that sort the same way, as are the
+   bit patterns of the value/cost ratios; each sort is stable, so sorting by
+   the tie-breaking key first and the main key second leaves ties in the tie
+   order and then in input order */
+struct k_radix_item
+{
+    uint64_t key;
+    size_t id;
+};
+static inline uint64_t k_key_int(int x)
+{
+    return (uint32_t)x ^ 0x80000000u;
+}
+static inline uint64_t k_key_double(double x)
+{
+    uint64_t bits;
+    memcpy(&bits,&x,sizeof(bits));
+    return bits>>63 ? ~bits : bits | (uint64_t)1<<63;
+}
+static void k_radix_sort(struct k_radix_item* items,struct k_radix_item* tmp,size_t cnt)
+{
+    /* 8 bits per pass; a pass whose digit is the same for every item is
+       skipped */
+    int pass;
+    size_t i, count[8][256];
+    struct k_radix_item* src = items, *dst = tmp;
+    if (cnt == 0)
+        return;
+    memset(count,0,sizeof(count));
+    for (i = 0;i < cnt;++i)
+        for (pass = 0;pass < 8;++pass)
+            ++count[pass][(items[i].key >> 8*pass) & 0xff];
+    for (pass = 0;pass < 8;++pass) {
+        size_t sum, d;
+        struct k_radix_item* swap;
+        int shift = 8*pass;
+        if (count[pass][(items[0].key >> shift) & 0xff] == cnt)
+            continue;
+        for (d = sum = 0;d < 256;++d) {
+            size_t n = count[pass][d];
+            count[pass][d] = sum;
+            sum += n;
+        }
+        for (i = 0;i < cnt;++i)
+            dst[count[pass][(src[i].key >> shift) & 0xff]++] = src[i];
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != items)
+        memcpy(items,src,sizeof(struct k_radix_item) * cnt);
+}
+static size_t* k_items_order(const struct k_items* items,struct k_radix_item* keys,struct k_radix_item* tmp,int which)
+{
+    size_t i;
+    size_t* order;
+    order = malloc(sizeof(size_t) * (items->cnt>0 ? items->cnt : 1));
+    if (order == NULL)
+        return NULL;
+    /* the value and cost orders fit the main and the tie-breaking key into
+       one sort; the ratio order needs one sort for each */
+    for (i = 0;i < items->cnt;++i) {
+        keys[i].id = i;
+        if (which == 0)
+            /* decreasing value; equal values: cheaper first */
+            keys[i].key = (~k_key_int(items->value[i]) & 0xffffffffu) << 32 | k_key_int(items->cost[i]);
+        else if (which == 1)
+            /* increasing cost; equal costs: more valuable first */
+            keys[i].key = k_key_int(items->cost[i]) << 32 | (~k_key_int(items->value[i]) & 0xffffffffu);
+        else
+            keys[i].key = k_key_int(items->cost[i]);
+    }
+    k_radix_sort(keys,tmp,items->cnt);
+    if (which == 2) {
+        /* decreasing ratio; equal ratios: cheaper first */
+        for (i = 0;i < items->cnt;++i)
+            keys[i].key = ~k_key_double(items->ratio[keys[i].id]);
+        k_radix_sort(keys,tmp,items->cnt);
+    }
+    for (i = 0;i < items->cnt;++i)
+        order[i] = keys[i].id;
+    return order;
+}
+int k_items_init(struct k_items* items,const int* cost,const int* value,size_t cnt)
+{
+    size_t i;
+    struct k_radix_item* keys, *tmp;
+    items->cnt = cnt;
+    items->cost = cost;
+    items->value = value;
+    items->ratio = malloc(sizeof(double) * (cnt>0 ? cnt : 1));
+    items->byValue = items->byCost = items->byRatio = NULL;
+    keys = malloc(sizeof(struct k_radix_item) * (cnt>0 ? cnt : 1));
+    tmp = malloc(sizeof(struct k_radix_item) * (cnt>0 ? cnt : 1));
+    if (items->ratio!=NULL && keys!=NULL && tmp!=NULL) {
+        for (i = 0;i < items->cnt;++i) {
+            if (items->cost[i] > 0)
+                items->ratio[i] = (double)items->value[i] / items->cost[i];
+            else
+                /* free items go first */
+                items->ratio[i] = items->value[i]>0 ? HUGE_VAL : 0.0;
+        }
+        items->byValue = k_items_order(items,keys,tmp,0);
+        items->byCost = k_items_order(items,keys,tmp,1);
+        items->byRatio = k_items_order(items,keys,tmp,2);
+    }
+    free(keys);
+    free(tmp);
+    if (items->ratio==NULL || items->byValue==NULL || items->byCost==NULL || items->byRatio==NULL) {
+        k_items_destroy(items);
+        return 0;
+    }
+    return 1;
+}
+void k_items_destroy(struct k_items* items)
+{
+    free(items->ratio);
+    free(items->byValue);
+    free(items->byCost);
+    free(items->byRatio);
+}
+
+/* k_set */
+int k_set_init(struct k_set* set,size_t cap)
+{
+    /* a set that could not be allocated is left empty and can still be
+       destroyed */
+    set->cnt = 0;
+    set->id = malloc(sizeof(size_t) * (cap+1));
+    set->cost = malloc(sizeof(int) * (cap+1));
+    set->value = malloc(sizeof(int) * (cap+1));
+    if (set->id==NULL || set->cost==NULL || set->value==NULL) {
+        k_set_destroy(set);
+        set->id = NULL;
+        set->cost = set->value = NULL;
+        return 0;
+    }
+    return 1;
+}
+void k_set_destroy(struct k_set* set)
+{
+    free(set->id);
+    free(set->cost);
+    free(set->value);
+}
+void k_set_add(struct k_set* set,size_t id,int cost,int value)
+{
+    set->id[set->cnt] = id;
+    set->cost[set->cnt] = cost;
+    set->value[set->cnt] = value;
+    ++set->cnt;
+}
+int k_set_order(struct k_set* set,const struct k_items* items,const size_t* order)
+{
+    /* put the set in the same order as one of the instance's orderings, or in
+       input order if 'order' is NULL */
+    size_t i, cnt;
+    unsigned char* member;
+    member = calloc(items->cnt>0 ? items->cnt : 1,1);
+    if (member == NULL)
+        return 0;
+    for (i = 0;i < set->cnt;++i)
+        member[set->id[i]] = 1;
+    cnt = set->cnt;
+    set->cnt = 0;
+    for (i = 0;i<items->cnt && set->cnt<cnt;++i) {
+        size_t id = order!=NULL ? order[i] : i;
+        if (member[id])
+            k_set_add(set,id,items->cost[id],items->value[id]);
+    }
+    free(member);
+    return 1;
+}
+size_t* k_set_classes(struct k_set* set)
+{
+    /* move each item next to the first item of the set with the same cost and
+       value, keeping the classes in the order of their first items, and
+       return for every position the position after its class; the value,
+       cost and ratio orders already keep identical items together; NULL is
+       returned with the set unchanged if memory runs out */
+    size_t i, j, cnt = set->cnt;
+    size_t* first, *classEnd;
+    struct k_radix_item* keys, *tmp;
+    keys = malloc(sizeof(struct k_radix_item) * (cnt>0 ? cnt : 1));
+    tmp = malloc(sizeof(struct k_radix_item) * (cnt>0 ? cnt : 1));
+    first = malloc(sizeof(size_t) * (cnt>0 ? cnt : 1));
+    classEnd = malloc(sizeof(size_t) * (cnt>0 ? cnt : 1));
+    if (keys==NULL || tmp==NULL || first==NULL || classEnd==NULL) {
+        free(classEnd);
+        classEnd = NULL;
+        goto done;
+    }
+    for (i = 0;i < cnt;++i) {
+        keys[i].key = k_key_int(set->cost[i]) << 32 | k_key_int(set->value[i]);
+        keys[i].id = i;
+    }
+    k_radix_sort(keys,tmp,cnt);
+    /* the sort is stable, so each class starts with its first position;
+       first[p] is the index in 'keys' where the class of position p starts */
+    for (i = 0;i < cnt;) {
+        size_t start = i;
+        for (j = i+1;j<cnt && keys[j].key==keys[start].key;++j)
+            ;
+        while (i < j)
+            first[keys[i++].id] = start;
+    }
+    /* the set is grouped if every item is either identical to the one
+       before it or the first of its class */
+    for (i = 1;i < cnt;++i)
+        if ((set->cost[i]!=set->cost[i-1] || set->value[i]!=set->value[i-1]) && keys[first[i]].id!=i)
+            break;
+    if (i < cnt) {
+        /* some class is split up; rebuild the set class by class */
+        struct k_set grouped;
+        if ( !k_set_init(&grouped,cnt) ) {
+            free(classEnd);
+            classEnd = NULL;
+            goto done;
+        }
+        for (i = 0;i < cnt;++i) {
+            if (keys[first[i]].id != i)
+                continue;
+            for (j = first[i];j<cnt && keys[j].key==keys[first[i]].key;++j)
+                k_set_add(&grouped,set->id[keys[j].id],set->cost[keys[j].id],set->value[keys[j].id]);
+        }
+        k_set_destroy(set);
+        *set = grouped;
+    }
+    for (i = cnt;i > 0;--i)
+        classEnd[i-1] = i<cnt && set->cost[i]==set->cost[i-1] && set->value[i]==set->value[i-1] ? classEnd[i] : i;
+done:
+    free(keys);
+    free(tmp);
+    free(first);
+    return classEnd;
+}
+
+/* k_sack */
+struct k_sack* k_sack_new()
+{
+    struct k_sack* sack;
+    sack = malloc(sizeof(struct k_sack));
+    if (sack == NULL)
+        return NULL;
+    sack->cost = sack->value = 0;
+    sack->itemCap = 4;
+    sack->itemSz = 0;
+    sack->items = malloc(sizeof(size_t) * sack->itemCap);
+    if (sack->items == NULL) {
+        free(sack);
+        return NULL;
+    }
+    return sack;
+}
+void k_sack_free(struct k_sack* sack)
+{
+    free(sack->items);
+    free(sack);
+}
+int k_sack_add_item(struct k_sack* sack,size_t id,int cost,int value)
+{
+    if (sack->itemSz >= sack->itemCap) {
+        size_t* newblock;
+        newblock = realloc(sack->items,sizeof(size_t) * (sack->itemCap<<1));
+        if (newblock == NULL)
+            return 0;
+        sack->items = newblock;
+        sack->itemCap <<= 1;
+    }
+    sack->items[sack->itemSz++] = id;
+    sack->cost += cost;
+    sack->value += value;
+    return 1;
+}
+void k_sack_release(struct k_sack* sack,struct knapsack_sack* out)
+{
+    /* hand the sack's items over to a public sack; NULL gives an empty one */
+    if (sack == NULL) {
+        out->cost = out->value = 0;
+        out->cnt = 0;
+        out->items = NULL;
+        return;
+    }
+    out->cost = sack->cost;
+    out->value = sack->value;
+    out->cnt = sack->itemSz;
+    out->items = sack->items;
+    free(sack);
+}
+
+/* k_partial_sack */
+struct k_partial_sack* k_partial_sack_new()
+{
+    int i;
+    struct k_partial_sack* psack;
+    psack = malloc(sizeof(struct k_partial_sack));
+    if (psack == NULL)
+        return NULL;
+    psack->cost = 0;
+    psack->value = 0.0;
+    for (i = 0;i < 2;++i) {
+        psack->itemCap[i] = 4;
+        psack->itemSz[i] = 0;
+        psack->items[i] = malloc(sizeof(size_t) * psack->itemCap[i]);
+    }
+    if (psack->items[0]==NULL || psack->items[1]==NULL) {
+        k_partial_sack_free(psack);
+        return NULL;
+    }
+    return psack;
+}
+void k_partial_sack_free(struct k_partial_sack* psack)
+{
+    free(psack->items[0]);
+    free(psack->items[1]);
+    free(psack);
+}
+int k_partial_sack_add_item(struct k_partial_sack* psack,const struct k_items* items,size_t id,int cost)
+{
+    int index;
+    double value = items->value[id];
+    if (items->cost[id] > 0)
+        /* an item of no cost is always taken whole */
+        value *= (double)cost / items->cost[id];
+    index = value < items->value[id] ? 1 : 0;
+    if (psack->itemSz[index] >= psack->itemCap[index]) {
+        size_t* newblock;
+        newblock = realloc(psack->items[index],sizeof(size_t) * (psack->itemCap[index]<<1));
+        if (newblock == NULL)
+            return 0;
+        psack->items[index] = newblock;
+        psack->itemCap[index] <<= 1;
+    }
+    psack->items[index][psack->itemSz[index]++] = id;
+    psack->cost += cost;
+    psack->value += value;
+    return 1;
+}
+
+/* k_solution */
+struct k_solution* k_solution_new()
+{
+    struct k_solution* sol;
+    sol = malloc(sizeof(struct k_solution));
+    if (sol == NULL)
+        return NULL;
+    sol->sackCounter = 0;
+    sol->nodeCounter = 0;
+    sol->costPrunes = sol->boundPrunes = 0;
+    sol->cpuSeconds = 0.0;
+    sol->sack = NULL;
+    return sol;
+}
+void k_solution_free(struct k_solution* sol)
+{
+    if (sol->sack != NULL)
+        k_sack_free(sol->sack);
+    free(sol);
+}
+int k_solution_check_sack(struct k_context* ctx,struct k_solution* sol,struct k_sack* sack)
+{
+    /* see if the sack is better than anything so far */
+    if (sack->cost<=ctx->info.limit && (sol->sack==NULL || sack->value>sol->sack->value)) {
+        if (sol->sack != NULL)
+            k_sack_free(sol->sack);
+        sol->sack = sack;
+        return 1;
+    }
+    return 0;
+}
+
+/* k_info functionality */
+void k_info_init(struct k_info* info)
+{
+    info->lowerValueBound = 0;
+    info->upperValueBound = 0;
+}
+int k_info_update_lower_value_bound(struct k_info* info,struct k_solution* sol)
+{
+    /* the bound may be raised concurrently by the parallel search; non-zero
+       is returned if this call raised it */
+    int bound = __atomic_load_n(&info->lowerValueBound,__ATOMIC_RELAXED);
+    while (sol->sack->value > bound)
+        if ( __atomic_compare_exchange_n(&info->lowerValueBound,&bound,sol->sack->value,0,__ATOMIC_RELAXED,__ATOMIC_RELAXED) )
+            return 1;
+    return 0;
+}
+
+/* k_bound_table */
+int k_bound_table_init(struct k_bound_table* table,const struct k_set* set)
+{
+    size_t i;
+    table->set = set;
+    table->cost = malloc(sizeof(long long) * (set->cnt+1));
+    table->value = malloc(sizeof(long long) * (set->cnt+1));
+    if (table->cost==NULL || table->value==NULL) {
+        k_bound_table_destroy(table);
+        return 0;
+    }
+    table->cost[0] = table->value[0] = 0;
+    for (i = 0;i < set->cnt;++i) {
+        table->cost[i+1] = table->cost[i] + set->cost[i];
+        table->value[i+1] = table->value[i] + set->value[i];
+    }
+    return 1;
+}
+void k_bound_table_destroy(struct k_bound_table* table)
+{
+    free(table->cost);
+    free(table->value);
+}
+int k_bound_table_upper(const struct k_bound_table* table,size_t index,int capacity)
+{
+    size_t lo, hi, cnt;
+    long long target;
+    double frac;
+    /* find the first k in (index,cnt] where items index..k-1 no longer fit;
+       item k-1 is then the critical item */
+    cnt = table->set->cnt;
+    target = table->cost[index] + capacity;
+    if (table->cost[cnt] <= target)
+        return (int)(table->value[cnt] - table->value[index]);
+    lo = index+1;
+    hi = cnt;
+    while (lo < hi) {
+        size_t mid = lo + (hi-lo)/2;
+        if (table->cost[mid] > target)
+            hi = mid;
+        else
+            lo = mid+1;
+    }
+    --lo;
+    /* whole items before the critical item plus a fraction of it */
+    frac = (double)(target - table->cost[lo]) * table->set->value[lo] / table->set->cost[lo];
+    return (int)(table->value[lo] - table->value[index]) + (int)floor(frac + 1e-9);
+}
+
+/* k_context */
+size_t k_context_next(const struct k_context* ctx,size_t index)
+{
+    /* the exclude branch at 'index' excludes the rest of the item's class as
+       well, so that the search branches on how many copies of identical
+       items it takes rather than on which ones */
+    return ctx->classEnd!=NULL ? ctx->classEnd[index] : index+1;
+}
+void k_context_collapse(struct k_context* ctx,struct k_set* set)
+{
+    /* collapsing only saves nodes, so the search goes on without it if
+       memory runs out */
+    if (ctx->opts->collapse)
+        ctx->classEnd = k_set_classes(set);
+}
+void k_context_fail(struct k_context* ctx)
+{
+    /* may be called from the parallel search threads */
+    __atomic_store_n(&ctx->failed,1,__ATOMIC_RELAXED);
+}
+
+/* k_search */
+int k_search_init(struct k_search* search,const struct k_set* set,struct k_context* ctx,struct k_solution* sol)
+{
+    search->cost = search->value = 0;
+    search->depth = 0;
+    search->stack = malloc(sizeof(size_t) * (set->cnt+1));
+    search->frames = malloc(sizeof(struct k_frame) * (set->cnt+1));
+    if (search->stack==NULL || search->frames==NULL) {
+        free(search->stack);
+        free(search->frames);
+        return 0;
+    }
+    search->set = set;
+    search->ctx = ctx;
+    search->sol = sol;
+    search->bound = NULL;
+    search->worker = NULL;
+    search->clockCheck = K_CLOCK_CHECK_NODES;
+    search->openBound = INT_MIN;
+    return 1;
+}
+void k_search_destroy(struct k_search* search)
+{
+    /* pass on the bound of anything left unexplored at the time limit */
+    int bound = __atomic_load_n(&search->ctx->openBound,__ATOMIC_RELAXED);
+    while (search->openBound > bound)
+        if ( __atomic_compare_exchange_n(&search->ctx->openBound,&bound,search->openBound,0,__ATOMIC_RELAXED,__ATOMIC_RELAXED) )
+            break;
+    free(search->stack);
+    free(search->frames);
+}
+void k_search_push(struct k_search* search,size_t index)
+{
+    search->stack[search->depth++] = index;
+    search->cost += search->set->cost[index];
+    search->value += search->set->value[index];
+}
+void k_search_pop(struct k_search* search)
+{
+    size_t index = search->stack[--search->depth];
+    search->cost -= search->set->cost[index];
+    search->value -= search->set->value[index];
+}
+int k_search_check_leaf(struct k_search* search)
+{
+    /* this is the same test as k_solution_check_sack; the current path is
+       copied into the solution sack only if it would be accepted */
+    struct k_solution* sol = search->sol;
+    if (search->cost<=search->ctx->info.limit && (sol->sack==NULL || search->value>sol->sack->value)) {
+        size_t i;
+        if (sol->sack==NULL && (sol->sack = k_sack_new())==NULL) {
+            k_context_fail(search->ctx);
+            return 0;
+        }
+        sol->sack->cost = sol->sack->value = 0;
+        sol->sack->itemSz = 0;
+        for (i = 0;i < search->depth;++i) {
+            size_t index = search->stack[i];
+            if ( !k_sack_add_item(sol->sack,search->set->id[index],search->set->cost[index],search->set->value[index]) ) {
+                k_context_fail(search->ctx);
+                return 0;
+            }
+        }
+        return 1;
+    }
+    return 0;
+}
+int k_search_cut(struct k_search* search,size_t index)
+{
+    /* a subtree is cut if its LP bound cannot reach the greedy lower bound or
+       cannot improve on the sack already found */
+    int upper;
+    upper = search->value + k_bound_table_upper(search->bound,index,search->ctx->info.limit - search->cost);
+    return upper<__atomic_load_n(&search->ctx->info.lowerValueBound,__ATOMIC_RELAXED) || (search->sol->sack!=NULL && upper<=search->sol->sack->value);
+}
+int k_search_expired(struct k_search* search,size_t index)
+{
+    /* the clock is only read every K_CLOCK_CHECK_NODES nodes; once the time
+       limit has passed, the subtree at 'index' is abandoned and its upper
+       bound is kept so that the optimality gap can be reported */
+    struct k_context* ctx = search->ctx;
+    if (ctx->opts->timeLimit <= 0.0)
+        return 0;
+    if (--search->clockCheck == 0) {
+        search->clockCheck = K_CLOCK_CHECK_NODES;
+        if (elapsed_seconds(&ctx->start) >= ctx->opts->timeLimit)
+            __atomic_store_n(&ctx->timedOut,1,__ATOMIC_RELAXED);
+    }
+    if ( !__atomic_load_n(&ctx->timedOut,__ATOMIC_RELAXED) )
+        return 0;
+    if (search->cost <= ctx->info.limit) {
+        int upper = search->value + k_bound_table_upper(search->bound,index,ctx->info.limit - search->cost);
+        if (upper > search->openBound)
+            search->openBound = upper;
+    }
+    return 1;
+}
+
+/* knapsack functionality and utilities */
+double elapsed_seconds(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC,&now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+double cpu_seconds()
+{
+    /* CPU time used by the calling thread */
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID,&now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+void knapsack_bruteforce_search(struct k_search* search)
+{
+    /* visit the subtree without the item at each node before the one with it */
+    size_t top = 0;
+    struct k_frame* frames = search->frames;
+    struct k_solution* sol = search->sol;
+    frames[0].index = 0;
+    frames[0].stage = 0;
+    while (1) {
+        struct k_frame* f = frames + top;
+        if (f->stage == 0) {
+            ++sol->nodeCounter;
+            if (f->index == search->set->cnt) {
+                ++sol->sackCounter;
+                k_search_check_leaf(search);
+            }
+            else {
+                f->stage = 1;
+                frames[++top].index = f->index+1;
+                frames[top].stage = 0;
+                continue;
+            }
+        }
+        else if (f->stage == 1) {
+            k_search_push(search,f->index);
+            f->stage = 2;
+            frames[++top].index = f->index+1;
+            frames[top].stage = 0;
+            continue;
+        }
+        else
+            k_search_pop(search);
+        if (top-- == 0)
+            break;
+    }
+}
+void knapsack_optimized1_search(struct k_search* search)
+{
+    /* the subtree with the item is always visited; the one without it only
+       if the path so far fits, so a path over the limit runs straight down
+       to its leaf */
+    size_t top = 0;
+    struct k_frame* frames = search->frames;
+    struct k_solution* sol = search->sol;
+    struct k_context* ctx = search->ctx;
+    frames[0].index = 0;
+    frames[0].stage = 0;
+    while (1) {
+        struct k_frame* f = frames + top;
+        if (f->stage == 0) {
+            ++sol->nodeCounter;
+            if (f->index < search->set->cnt) {
+                k_search_push(search,f->index);
+                f->stage = 1;
+                frames[++top].index = f->index+1;
+                frames[top].stage = 0;
+                continue;
+            }
+            ++sol->sackCounter;
+            k_search_check_leaf(search);
+        }
+        else {
+            k_search_pop(search);
+            if (search->cost <= ctx->info.limit) {
+                /* the subtree without the item replaces this node */
+                f->index = k_context_next(ctx,f->index);
+                f->stage = 0;
+                continue;
+            }
+            ++sol->costPrunes;
+        }
+        if (top-- == 0)
+            break;
+    }
+}
+void knapsack_optimized2_search(struct k_search* search)
+{
+    /* as optimized1, but a leaf below the lower value bound fails, and a node
+       whose subtree with the item failed fails without visiting the one
+       without it; 'ok' is the result of the node last finished */
+    int ok = 1;
+    size_t top = 0;
+    struct k_frame* frames = search->frames;
+    struct k_solution* sol = search->sol;
+    struct k_context* ctx = search->ctx;
+    frames[0].index = 0;
+    frames[0].stage = 0;
+    while (1) {
+        struct k_frame* f = frames + top;
+        if (f->stage == 0) {
+            ++sol->nodeCounter;
+            if (f->index < search->set->cnt) {
+                k_search_push(search,f->index);
+                f->stage = 1;
+                frames[++top].index = f->index+1;
+                frames[top].stage = 0;
+                continue;
+            }
+            ++sol->sackCounter;
+            if (search->value < ctx->info.lowerValueBound) {
+                ++sol->boundPrunes;
+                ok = 0;
+            }
+            else {
+                k_search_check_leaf(search);
+                ok = 1;
+            }
+        }
+        else if (f->stage == 1) {
+            k_search_pop(search);
+            if (ok && search->cost<=ctx->info.limit) {
+                f->stage = 2;
+                frames[++top].index = k_context_next(ctx,f->index);
+                frames[top].stage = 0;
+                continue;
+            }
+            if (ok)
+                ++sol->costPrunes;
+        }
+        else
+            /* the result of the subtree without the item does not count */
+            ok = 1;
+        if (top-- == 0)
+            break;
+    }
+}
+/* the Gray-code kernel enumerates every subset of up to 63 items without
+   building any sacks: the low items are expanded into a table of the cost and
+   value of each of their subsets, and the high items are walked in Gray-code
+   order so that each step adds or removes exactly one item; every step then
+   scans the low table for the best subset that still fits */
+enum k_gray_constants
+{
+    K_GRAY_LOW_ITEMS = 8,
+    K_GRAY_MAX_ITEMS = 63
+};
+static int knapsack_gray_scan(const int* lowCost,const int* lowValue,size_t lowCnt,int room)
+{
+    /* find the best value of any low subset that costs no more than 'room' */
+    size_t j = 0;
+    int best = INT_MIN;
+#ifdef __AVX2__
+    __m256i vroom, vbest, vmin;
+    vroom = _mm256_set1_epi32(room);
+    vmin = _mm256_set1_epi32(INT_MIN);
+    vbest = vmin;
+    for (;j+8 <= lowCnt;j += 8) {
+        __m256i cost, value, over;
+        cost = _mm256_loadu_si256((const __m256i*)(lowCost+j));
+        value = _mm256_loadu_si256((const __m256i*)(lowValue+j));
+        over = _mm256_cmpgt_epi32(cost,vroom);
+        vbest = _mm256_max_epi32(vbest,_mm256_blendv_epi8(value,vmin,over));
+    }
+    {
+        int lanes[8], k;
+        _mm256_storeu_si256((__m256i*)lanes,vbest);
+        for (k = 0;k < 8;++k)
+            if (lanes[k] > best)
+                best = lanes[k];
+    }
+#endif
+    for (;j < lowCnt;++j) {
+        int v = lowCost[j]<=room ? lowValue[j] : INT_MIN;
+        best = v>best ? v : best;
+    }
+    return best;
+}
+static void knapsack_bruteforce_gray(struct k_context* ctx,const struct k_set* set)
+{
+    size_t lowItems, lowCnt, highItems, i, j, bestLow;
+    uint64_t step, steps, mask, bestMask;
+    int lowCost[1 << K_GRAY_LOW_ITEMS], lowValue[1 << K_GRAY_LOW_ITEMS];
+    int cost, value, best;
+    size_t cnt = set->cnt;
+    struct k_sack* sack;
+    lowItems = cnt<K_GRAY_LOW_ITEMS ? cnt : K_GRAY_LOW_ITEMS;
+    lowCnt = (size_t)1 << lowItems;
+    highItems = cnt - lowItems;
+    /* partial sums of each subset of the low items */
+    lowCost[0] = lowValue[0] = 0;
+    for (i = 0;i < lowItems;++i) {
+        size_t half = (size_t)1 << i;
+        for (j = 0;j < half;++j) {
+            lowCost[half+j] = lowCost[j] + set->cost[i];
+            lowValue[half+j] = lowValue[j] + set->value[i];
+        }
+    }
+    /* walk the high items in Gray-code order */
+    cost = value = 0;
+    mask = bestMask = 0;
+    bestLow = 0;
+    best = INT_MIN;
+    steps = (uint64_t)1 << highItems;
+    for (step = 0;step < steps;++step) {
+        int lowBest;
+        if (step > 0) {
+            /* the bit that changes between Gray codes step-1 and step is the
+               lowest set bit of step */
+            int bit = __builtin_ctzll(step);
+            size_t flip = lowItems + bit;
+            mask ^= (uint64_t)1 << bit;
+            if ((mask >> bit) & 1) {
+                cost += set->cost[flip];
+                value += set->value[flip];
+            }
+            else {
+                cost -= set->cost[flip];
+                value -= set->value[flip];
+            }
+        }
+        if (cost > ctx->info.limit)
+            continue;
+        lowBest = knapsack_gray_scan(lowCost,lowValue,lowCnt,ctx->info.limit - cost);
+        if (lowBest!=INT_MIN && value+lowBest>best) {
+            /* find which low subset it was */
+            for (j = 0;j < lowCnt;++j)
+                if (lowCost[j]<=ctx->info.limit-cost && lowValue[j]==lowBest)
+                    break;
+            best = value + lowBest;
+            bestMask = mask;
+            bestLow = j;
+        }
+    }
+    /* every subset is a leaf of the brute-force tree; with 63 items the node
+       count 2^64-1 does not fit and wraps */
+    ctx->solution->sackCounter = (size_t)1 << cnt;
+    ctx->solution->nodeCounter = 2*ctx->solution->sackCounter - 1;
+    if (best == INT_MIN)
+        return;
+    if ((sack = k_sack_new()) == NULL) {
+        k_context_fail(ctx);
+        return;
+    }
+    for (i = 0;i < cnt;++i)
+        if ((i<lowItems ? (bestLow>>i) & 1 : (bestMask>>(i-lowItems)) & 1)
+            && !k_sack_add_item(sack,set->id[i],set->cost[i],set->value[i])) {
+            k_sack_free(sack);
+            k_context_fail(ctx);
+            return;
+        }
+    k_solution_check_sack(ctx,ctx->solution,sack);
+}
+void knapsack_bruteforce(struct k_context* ctx,struct k_set* set)
+{
+    struct k_search search;
+    if (set->cnt <= K_GRAY_MAX_ITEMS) {
+        knapsack_bruteforce_gray(ctx,set);
+        return;
+    }
+    /* do a brute-force exhaustive search that explores all of the candidate
+       solutions; the k_solution will find the best sack as it generates them */
+    if ( !k_search_init(&search,set,ctx,ctx->solution) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    knapsack_bruteforce_search(&search);
+    k_search_destroy(&search);
+}
+void knapsack_optimized1(struct k_context* ctx,struct k_set* set)
+{
+    /* do an exhaustive search that optimizes out sub-trees that exceed cost limit */
+    struct k_search search;
+    k_context_collapse(ctx,set);
+    if ( !k_search_init(&search,set,ctx,ctx->solution) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    knapsack_optimized1_search(&search);
+    k_search_destroy(&search);
+}
+void knapsack_optimized2(struct k_context* ctx,struct k_set* set)
+{
+    /* do an exhaustive search that optimizes out sub-trees whose value does not reach
+       the lower value bound; this optimization is performed in addition to the one above */
+    struct k_search search;
+    k_context_collapse(ctx,set);
+    if ( !k_search_init(&search,set,ctx,ctx->solution) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    knapsack_optimized2_search(&search);
+    k_search_destroy(&search);
+}
+static void knapsack_report_incumbent(struct k_context* ctx,int value)
+{
+    /* anytime mode: report each new best sack along with the LP bound of the
+       problem so that the caller can tell how far it may still be from optimal */
+    if (ctx->opts->incumbent != NULL)
+        ctx->opts->incumbent(ctx->opts->arg,value + ctx->fixedValue,ctx->info.upperValueBound,elapsed_seconds(&ctx->start));
+}
+void knapsack_optimized3_search(struct k_search* search,size_t index)
+{
+    /* search the subtree at 'index' below the current path; the subtree with
+       the item comes first, and the one without it replaces the node on the
+       frame stack unless it is donated to an idle thread */
+    size_t top = 0;
+    struct k_frame* frames = search->frames;
+    struct k_solution* sol = search->sol;
+    struct k_context* ctx = search->ctx;
+    frames[0].index = index;
+    frames[0].stage = 0;
+    while (1) {
+        struct k_frame* f = frames + top;
+        if (f->stage==0 && !k_search_expired(search,f->index)) {
+            ++sol->nodeCounter;
+            if (f->index == search->set->cnt) {
+                ++sol->sackCounter;
+                if (k_search_check_leaf(search) && k_info_update_lower_value_bound(&ctx->info,sol) && ctx->opts->timeLimit>0.0)
+                    knapsack_report_incumbent(ctx,sol->sack->value);
+            }
+            else if (search->cost > ctx->info.limit)
+                ++sol->costPrunes;
+            else if ( k_search_cut(search,f->index) )
+                ++sol->boundPrunes;
+            else {
+                k_search_push(search,f->index);
+                f->stage = 1;
+                frames[++top].index = f->index+1;
+                frames[top].stage = 0;
+                continue;
+            }
+        }
+        else if (f->stage == 1) {
+            size_t next = k_context_next(ctx,f->index);
+            k_search_pop(search);
+            if (search->worker==NULL || !knapsack_parallel_donate(search,next)) {
+                f->index = next;
+                f->stage = 0;
+                continue;
+            }
+        }
+        if (top-- == 0)
+            break;
+    }
+}
+void knapsack_optimized3(struct k_context* ctx,struct k_set* set)
+{
+    struct k_search search;
+    struct k_bound_table bound;
+    /* the LP bound is only valid if the items are visited in order of
+       decreasing value/cost ratio */
+    if ( !k_set_order(set,ctx->items,ctx->items->byRatio) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    k_context_collapse(ctx,set);
+    if ( !k_bound_table_init(&bound,set) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    if ( !k_search_init(&search,set,ctx,ctx->solution) ) {
+        k_bound_table_destroy(&bound);
+        k_context_fail(ctx);
+        return;
+    }
+    search.bound = &bound;
+    knapsack_optimized3_search(&search,0);
+    k_search_destroy(&search);
+    k_bound_table_destroy(&bound);
+}
+/* the parallel search splits the optimized search tree at a fixed depth into
+   tasks which are dealt out to per-thread deques; a thread pops tasks from the
+   back of its own deque and steals from the front of the others' once its own
+   is empty; while any thread is idle, busy threads donate the exclude branch of
+   the node they are at as a new task; a thread that finds no task sleeps on
+   a condition variable until a task is pushed or the last one finishes; a
+   sack found by any thread raises ctx->info.lowerValueBound, which every
+   thread prunes against */
+struct k_task
+{
+    size_t index; /* index of the next item to decide */
+    size_t depth; /* number of items included on the path to the task */
+    size_t* path; /* positions of the included items in the set */
+};
+struct k_deque
+{
+    pthread_mutex_t lock;
+    size_t head, tail, cap;
+    struct k_task* tasks;
+};
+struct k_parallel
+{
+    struct k_context* ctx;
+    const struct k_set* set;
+    size_t depth;
+    struct k_bound_table bound;
+    size_t threads;
+    struct k_deque* deques;
+    size_t taskCnt; /* number of tasks created */
+    size_t pending; /* number of tasks created but not finished */
+    size_t idle; /* number of threads looking for work */
+    /* idle threads wait on 'wake' for 'pushes' to change or 'pending' to
+       reach zero */
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    size_t pushes; /* number of tasks pushed so far */
+};
+struct k_worker
+{
+    pthread_t thread;
+    size_t id;
+    struct k_parallel* par;
+    struct k_solution* sol;
+    size_t tasks; /* number of tasks this worker ran */
+    size_t steals; /* number of those tasks stolen from another worker */
+    double seconds;
+    int running; /* set if the thread was started */
+};
+static int knapsack_parallel_deque_push(struct k_parallel* par,struct k_deque* deque,struct k_search* search,size_t index)
+{
+    /* zero is returned, with nothing queued, if memory runs out */
+    size_t* path;
+    struct k_task* task;
+    path = malloc(sizeof(size_t) * (search->depth+1));
+    if (path == NULL)
+        return 0;
+    memcpy(path,search->stack,sizeof(size_t) * search->depth);
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail>=deque->cap && deque->head>0) {
+        /* slide the live tasks to the front before growing */
+        memmove(deque->tasks,deque->tasks+deque->head,sizeof(struct k_task) * (deque->tail-deque->head));
+        deque->tail -= deque->head;
+        deque->head = 0;
+    }
+    if (deque->tail >= deque->cap) {
+        size_t cap = deque->cap==0 ? 16 : deque->cap<<1;
+        struct k_task* newblock;
+        newblock = realloc(deque->tasks,sizeof(struct k_task) * cap);
+        if (newblock == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            free(path);
+            return 0;
+        }
+        deque->tasks = newblock;
+        deque->cap = cap;
+    }
+    task = deque->tasks + deque->tail++;
+    task->index = index;
+    task->depth = search->depth;
+    task->path = path;
+    /* counted before the lock is let go, so no thread can finish the task
+       before it is pending */
+    __atomic_add_fetch(&par->pending,1,__ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&par->taskCnt,1,__ATOMIC_RELAXED);
+    pthread_mutex_unlock(&deque->lock);
+    pthread_mutex_lock(&par->lock);
+    __atomic_add_fetch(&par->pushes,1,__ATOMIC_SEQ_CST);
+    pthread_cond_signal(&par->wake);
+    pthread_mutex_unlock(&par->lock);
+    return 1;
+}
+static int knapsack_parallel_deque_take(struct k_deque* deque,struct k_task* task,int steal)
+{
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->head < deque->tail) {
+        *task = steal ? deque->tasks[deque->head++] : deque->tasks[--deque->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+int knapsack_parallel_donate(struct k_search* search,size_t index)
+{
+    /* called by the search before it explores the exclude branch at 'index';
+       the branch is handed to the worker's deque if another thread is idle
+       and nothing is queued there yet; if it cannot be queued, the search
+       goes on into it itself */
+    int empty;
+    struct k_parallel* par = search->worker->par;
+    struct k_deque* deque = par->deques + search->worker->id;
+    if (__atomic_load_n(&par->idle,__ATOMIC_RELAXED) == 0)
+        return 0;
+    pthread_mutex_lock(&deque->lock);
+    empty = deque->head == deque->tail;
+    pthread_mutex_unlock(&deque->lock);
+    if ( !empty )
+        return 0;
+    return knapsack_parallel_deque_push(par,deque,search,index);
+}
+static void knapsack_parallel_split(struct k_parallel* par,struct k_search* search,size_t index)
+{
+    /* generate the initial tasks by walking the top of the tree with the usual
+       pruning; the root node of each task is counted by the worker that runs it */
+    if (index>=par->depth || index==par->set->cnt) {
+        if ( !knapsack_parallel_deque_push(par,par->deques + par->taskCnt % par->threads,search,index) )
+            k_context_fail(search->ctx);
+        return;
+    }
+    ++search->sol->nodeCounter;
+    if (search->cost > search->ctx->info.limit)
+        ++search->sol->costPrunes;
+    else if ( k_search_cut(search,index) )
+        ++search->sol->boundPrunes;
+    else {
+        k_search_push(search,index);
+        knapsack_parallel_split(par,search,index+1);
+        k_search_pop(search);
+        knapsack_parallel_split(par,search,k_context_next(search->ctx,index));
+    }
+}
+static void* knapsack_parallel_worker(void* arg)
+{
+    size_t i, seen;
+    int idle = 0;
+    struct k_task task;
+    struct k_search search;
+    struct timespec start;
+    struct k_worker* worker = arg;
+    struct k_parallel* par = worker->par;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    if ( !k_search_init(&search,par->set,par->ctx,worker->sol) ) {
+        /* the other threads steal this one's tasks */
+        k_context_fail(par->ctx);
+        return NULL;
+    }
+    search.bound = &par->bound;
+    search.worker = worker;
+    while (1) {
+        /* a push after this is seen by the wait below, even if the scan
+           misses its task */
+        seen = __atomic_load_n(&par->pushes,__ATOMIC_SEQ_CST);
+        if ( !knapsack_parallel_deque_take(par->deques+worker->id,&task,0) ) {
+            /* our deque is empty: steal from the others */
+            for (i = 1;i < par->threads;++i)
+                if ( knapsack_parallel_deque_take(par->deques + (worker->id+i) % par->threads,&task,1) )
+                    break;
+            if (i >= par->threads) {
+                /* nothing to steal; we are done once every task has finished,
+                   otherwise wait for a busy thread to donate one */
+                if (__atomic_load_n(&par->pending,__ATOMIC_SEQ_CST) == 0)
+                    break;
+                if ( !idle ) {
+                    __atomic_add_fetch(&par->idle,1,__ATOMIC_RELAXED);
+                    idle = 1;
+                }
+                pthread_mutex_lock(&par->lock);
+                while (__atomic_load_n(&par->pushes,__ATOMIC_SEQ_CST)==seen && __atomic_load_n(&par->pending,__ATOMIC_SEQ_CST)!=0)
+                    pthread_cond_wait(&par->wake,&par->lock);
+                pthread_mutex_unlock(&par->lock);
+                continue;
+            }
+            ++worker->steals;
+        }
+        if (idle) {
+            __atomic_sub_fetch(&par->idle,1,__ATOMIC_RELAXED);
+            idle = 0;
+        }
+        ++worker->tasks;
+        /* rebuild the path to the task's root node */
+        while (search.depth > 0)
+            k_search_pop(&search);
+        for (i = 0;i < task.depth;++i)
+            k_search_push(&search,task.path[i]);
+        free(task.path);
+        knapsack_optimized3_search(&search,task.index);
+        if (__atomic_sub_fetch(&par->pending,1,__ATOMIC_SEQ_CST) == 0) {
+            /* the last task is done: release the waiting threads */
+            pthread_mutex_lock(&par->lock);
+            pthread_cond_broadcast(&par->wake);
+            pthread_mutex_unlock(&par->lock);
+        }
+    }
+    if (idle)
+        __atomic_sub_fetch(&par->idle,1,__ATOMIC_RELAXED);
+    k_search_destroy(&search);
+    worker->seconds = elapsed_seconds(&start);
+    worker->sol->cpuSeconds = cpu_seconds();
+    return NULL;
+}
+void knapsack_parallel(struct k_context* ctx,struct k_set* set)
+{
+    size_t cnt, i, running;
+    struct k_search search;
+    struct k_parallel par;
+    struct k_worker* workers;
+    struct knapsack_result* result = ctx->result;
+    if ( !k_set_order(set,ctx->items,ctx->items->byRatio) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    k_context_collapse(ctx,set);
+    cnt = set->cnt;
+    par.ctx = ctx;
+    par.set = set;
+    par.threads = ctx->opts->threads>0 ? ctx->opts->threads : 1;
+    if ( !k_bound_table_init(&par.bound,set) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    /* by default split deep enough for about 16 tasks per thread */
+    if (ctx->opts->splitDepth > 0)
+        par.depth = ctx->opts->splitDepth;
+    else
+        for (par.depth = 4;((size_t)1 << par.depth) < par.threads*16;++par.depth)
+            ;
+    if (par.depth > cnt)
+        par.depth = cnt;
+    par.deques = malloc(sizeof(struct k_deque) * par.threads);
+    workers = calloc(par.threads,sizeof(struct k_worker));
+    result->threadStats = calloc(par.threads,sizeof(struct knapsack_thread_stats));
+    if (par.deques==NULL || workers==NULL || result->threadStats==NULL) {
+        free(par.deques);
+        free(workers);
+        k_bound_table_destroy(&par.bound);
+        k_context_fail(ctx);
+        return;
+    }
+    for (i = 0;i < par.threads;++i) {
+        pthread_mutex_init(&par.deques[i].lock,NULL);
+        par.deques[i].head = par.deques[i].tail = par.deques[i].cap = 0;
+        par.deques[i].tasks = NULL;
+        workers[i].id = i;
+        workers[i].par = &par;
+        workers[i].sol = k_solution_new();
+        if (workers[i].sol == NULL)
+            k_context_fail(ctx);
+    }
+    par.taskCnt = par.pending = par.idle = par.pushes = 0;
+    pthread_mutex_init(&par.lock,NULL);
+    pthread_cond_init(&par.wake,NULL);
+    if ( !ctx->failed ) {
+        if ( k_search_init(&search,set,ctx,ctx->solution) ) {
+            search.bound = &par.bound;
+            knapsack_parallel_split(&par,&search,0);
+            k_search_destroy(&search);
+        }
+        else
+            k_context_fail(ctx);
+    }
+    /* run the workers; the tasks of a thread that cannot be started are
+       stolen by the others, and if none starts the calling thread runs them */
+    running = 0;
+    if ( !ctx->failed ) {
+        for (i = 0;i < par.threads;++i) {
+            workers[i].running = pthread_create(&workers[i].thread,NULL,knapsack_parallel_worker,workers+i) == 0;
+            running += workers[i].running;
+        }
+        if (running == 0) {
+            knapsack_parallel_worker(workers);
+            /* the calling thread's time is counted by knapsack_solve() */
+            workers[0].sol->cpuSeconds = 0.0;
+        }
+    }
+    for (i = 0;i < par.threads;++i)
+        if (workers[i].running)
+            pthread_join(workers[i].thread,NULL);
+    /* aggregate the counters and keep the best sack of all the threads */
+    for (i = 0;i < par.threads;++i) {
+        struct k_solution* sol = workers[i].sol;
+        if (sol == NULL)
+            continue;
+        ctx->solution->nodeCounter += sol->nodeCounter;
+        ctx->solution->sackCounter += sol->sackCounter;
+        ctx->solution->costPrunes += sol->costPrunes;
+        ctx->solution->boundPrunes += sol->boundPrunes;
+        ctx->solution->cpuSeconds += sol->cpuSeconds;
+        result->threadStats[i].tasks = workers[i].tasks;
+        result->threadStats[i].steals = workers[i].steals;
+        result->threadStats[i].nodes = sol->nodeCounter;
+        result->threadStats[i].seconds = workers[i].seconds;
+        if (sol->sack!=NULL && k_solution_check_sack(ctx,ctx->solution,sol->sack))
+            sol->sack = NULL;
+    }
+    result->threads = par.threads;
+    result->splitDepth = par.depth;
+    result->tasks = par.taskCnt;
+    for (i = 0;i < par.threads;++i) {
+        struct k_deque* deque = par.deques + i;
+        /* tasks are only left over if the search failed */
+        while (deque->head < deque->tail)
+            free(deque->tasks[deque->head++].path);
+        if (workers[i].sol != NULL)
+            k_solution_free(workers[i].sol);
+        pthread_mutex_destroy(&deque->lock);
+        free(deque->tasks);
+    }
+    pthread_mutex_destroy(&par.lock);
+    pthread_cond_destroy(&par.wake);
+    free(workers);
+    free(par.deques);
+    k_bound_table_destroy(&par.bound);
+}
+
+/* the best-first search keeps the open nodes of the optimized search tree in
+   a binary heap ordered by their LP bound, so a node is only expanded if its
+   bound beats every sack found so far and the search stops as soon as the best
+   open bound cannot improve on the incumbent; each node records which of the
+   items before its depth it includes in a bitset held in a pooled arena; once
+   the queue and arena would grow past the memory cap, new subtrees are
+   searched depth-first on the spot instead of being queued */
+struct k_bf_node
+{
+    int upper; /* LP bound of the subtree */
+    int cost;
+    int value;
+    unsigned depth; /* items 0..depth-1 of the set are decided */
+    size_t path; /* slot of the node's bitset in the arena */
+};
+struct k_best_first
+{
+    struct k_context* ctx;
+    const struct k_set* set;
+    struct k_bound_table bound;
+    struct k_bf_node* heap;
+    size_t cnt, cap;
+    uint64_t* arena; /* 'words' words per slot */
+    size_t words;
+    size_t slots; /* slots handed out so far */
+    size_t* freeSlots; /* slots given back by expanded nodes */
+    size_t freeCnt;
+    size_t maxNodes; /* queue length allowed by the memory cap */
+    struct k_search dfs; /* searches the subtrees that do not fit in the queue */
+};
+static inline int knapsack_best_first_before(const struct k_bf_node* a,const struct k_bf_node* b)
+{
+    /* higher bound first; equal bounds: deeper first, which reaches leaves
+       (and so incumbents) sooner */
+    return a->upper>b->upper || (a->upper==b->upper && a->depth>b->depth);
+}
+static void knapsack_best_first_push(struct k_best_first* bf,const struct k_bf_node* node)
+{
+    size_t i = bf->cnt++;
+    while (i > 0) {
+        size_t parent = (i-1) / 2;
+        if ( !knapsack_best_first_before(node,bf->heap+parent) )
+            break;
+        bf->heap[i] = bf->heap[parent];
+        i = parent;
+    }
+    bf->heap[i] = *node;
+}
+static void knapsack_best_first_pop(struct k_best_first* bf,struct k_bf_node* node)
+{
+    size_t i, child;
+    struct k_bf_node last;
+    *node = bf->heap[0];
+    last = bf->heap[--bf->cnt];
+    i = 0;
+    while ((child = 2*i+1) < bf->cnt) {
+        if (child+1<bf->cnt && knapsack_best_first_before(bf->heap+child+1,bf->heap+child))
+            ++child;
+        if ( !knapsack_best_first_before(bf->heap+child,&last) )
+            break;
+        bf->heap[i] = bf->heap[child];
+        i = child;
+    }
+    bf->heap[i] = last;
+}
+static size_t knapsack_best_first_slot(struct k_best_first* bf)
+{
+    /* a free bitset slot; the heap and the arena grow together since every
+       queued node holds exactly one slot; SIZE_MAX is returned if they
+       cannot grow */
+    if (bf->freeCnt > 0)
+        return bf->freeSlots[--bf->freeCnt];
+    if (bf->slots >= bf->cap) {
+        size_t cap = bf->cap*2<=bf->maxNodes ? bf->cap*2 : bf->maxNodes+1;
+        struct k_bf_node* heap;
+        uint64_t* arena;
+        size_t* freeSlots;
+        heap = realloc(bf->heap,sizeof(struct k_bf_node) * cap);
+        if (heap != NULL)
+            bf->heap = heap;
+        arena = realloc(bf->arena,sizeof(uint64_t) * bf->words * cap);
+        if (arena != NULL)
+            bf->arena = arena;
+        freeSlots = realloc(bf->freeSlots,sizeof(size_t) * cap);
+        if (freeSlots != NULL)
+            bf->freeSlots = freeSlots;
+        if (heap==NULL || arena==NULL || freeSlots==NULL)
+            return SIZE_MAX;
+        bf->cap = cap;
+    }
+    return bf->slots++;
+}
+static void knapsack_best_first_leaf(struct k_best_first* bf,const uint64_t* path,int value)
+{
+    size_t i;
+    struct k_sack* sack;
+    struct k_context* ctx = bf->ctx;
+    ++ctx->solution->sackCounter;
+    if (ctx->solution->sack!=NULL && value<=ctx->solution->sack->value)
+        return;
+    if ((sack = k_sack_new()) == NULL) {
+        k_context_fail(ctx);
+        return;
+    }
+    for (i = 0;i < bf->set->cnt;++i)
+        if (((path[i/64] >> i%64) & 1) && !k_sack_add_item(sack,bf->set->id[i],bf->set->cost[i],bf->set->value[i])) {
+            k_sack_free(sack);
+            k_context_fail(ctx);
+            return;
+        }
+    if (!k_solution_check_sack(ctx,ctx->solution,sack))
+        k_sack_free(sack);
+    else if (k_info_update_lower_value_bound(&ctx->info,ctx->solution) && ctx->opts->timeLimit>0.0)
+        knapsack_report_incumbent(ctx,ctx->solution->sack->value);
+}
+static void knapsack_best_first_depth_first(struct k_best_first* bf,const uint64_t* path,const struct k_bf_node* node)
+{
+    /* rebuild the node's path on the depth-first search stack and search its
+       subtree; the node itself is counted by the recursion */
+    size_t i;
+    struct k_search* search = &bf->dfs;
+    search->depth = 0;
+    search->cost = search->value = 0;
+    for (i = 0;i < node->depth;++i)
+        if ((path[i/64] >> i%64) & 1)
+            k_search_push(search,i);
+    --bf->ctx->solution->nodeCounter;
+    knapsack_optimized3_search(search,node->depth);
+    ++bf->ctx->result->fallbacks;
+}
+static void knapsack_best_first_child(struct k_best_first* bf,struct k_bf_node* child,size_t slot)
+{
+    /* count, cut, queue or search a new node whose bitset is in 'slot';
+       non-zero is returned if the node kept the slot */
+    struct k_context* ctx = bf->ctx;
+    const uint64_t* path = bf->arena + slot*bf->words;
+    ++ctx->solution->nodeCounter;
+    if (child->cost > ctx->info.limit) {
+        ++ctx->solution->costPrunes;
+        bf->freeSlots[bf->freeCnt++] = slot;
+        return;
+    }
+    if (child->depth == bf->set->cnt) {
+        knapsack_best_first_leaf(bf,path,child->value);
+        bf->freeSlots[bf->freeCnt++] = slot;
+        return;
+    }
+    child->upper = child->value + k_bound_table_upper(&bf->bound,child->depth,ctx->info.limit - child->cost);
+    if (child->upper<ctx->info.lowerValueBound || (ctx->solution->sack!=NULL && child->upper<=ctx->solution->sack->value)) {
+        ++ctx->solution->boundPrunes;
+        bf->freeSlots[bf->freeCnt++] = slot;
+        return;
+    }
+    if (bf->cnt < bf->maxNodes) {
+        child->path = slot;
+        knapsack_best_first_push(bf,child);
+        if (bf->cnt > ctx->result->peakQueue)
+            ctx->result->peakQueue = bf->cnt;
+        return;
+    }
+    knapsack_best_first_depth_first(bf,path,child);
+    bf->freeSlots[bf->freeCnt++] = slot;
+}
+void knapsack_best_first(struct k_context* ctx,struct k_set* set)
+{
+    size_t perNode, slot;
+    unsigned clockCheck;
+    struct k_bf_node node, child;
+    struct k_best_first bf;
+    struct knapsack_result* result = ctx->result;
+    if (set->cnt > UINT_MAX) {
+        knapsack_optimized3(ctx,set);
+        return;
+    }
+    /* ratio order for the LP bound, as in the optimized search */
+    if ( !k_set_order(set,ctx->items,ctx->items->byRatio) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    k_context_collapse(ctx,set);
+    bf.ctx = ctx;
+    bf.set = set;
+    if ( !k_bound_table_init(&bf.bound,set) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    bf.words = set->cnt/64 + 1;
+    perNode = sizeof(struct k_bf_node) + sizeof(uint64_t)*bf.words + sizeof(size_t);
+    /* the node being expanded holds a slot besides the queued ones */
+    bf.maxNodes = ctx->opts->queueMemory / perNode;
+    if (bf.maxNodes < 2)
+        bf.maxNodes = 2;
+    --bf.maxNodes;
+    bf.cap = bf.maxNodes<1024 ? bf.maxNodes+1 : 1024;
+    bf.heap = malloc(sizeof(struct k_bf_node) * bf.cap);
+    bf.arena = malloc(sizeof(uint64_t) * bf.words * bf.cap);
+    bf.freeSlots = malloc(sizeof(size_t) * bf.cap);
+    if (bf.heap==NULL || bf.arena==NULL || bf.freeSlots==NULL || !k_search_init(&bf.dfs,set,ctx,ctx->solution)) {
+        free(bf.heap);
+        free(bf.arena);
+        free(bf.freeSlots);
+        k_bound_table_destroy(&bf.bound);
+        k_context_fail(ctx);
+        return;
+    }
+    bf.cnt = bf.slots = bf.freeCnt = 0;
+    bf.dfs.bound = &bf.bound;
+    /* the root */
+    child.cost = child.value = 0;
+    child.depth = 0;
+    slot = knapsack_best_first_slot(&bf);
+    memset(bf.arena + slot*bf.words,0,sizeof(uint64_t) * bf.words);
+    knapsack_best_first_child(&bf,&child,slot);
+    clockCheck = K_CLOCK_CHECK_NODES;
+    while (bf.cnt > 0) {
+        uint64_t* path;
+        int best = ctx->solution->sack!=NULL ? ctx->solution->sack->value : INT_MIN;
+        if (bf.heap[0].upper<ctx->info.lowerValueBound || bf.heap[0].upper<=best) {
+            /* no open node can improve on the incumbent */
+            ctx->solution->boundPrunes += bf.cnt;
+            break;
+        }
+        if (ctx->opts->timeLimit > 0.0) {
+            if (--clockCheck == 0) {
+                clockCheck = K_CLOCK_CHECK_NODES;
+                if (elapsed_seconds(&ctx->start) >= ctx->opts->timeLimit)
+                    ctx->timedOut = 1;
+            }
+            if (ctx->timedOut) {
+                /* the best open bound bounds everything left unexplored */
+                if (bf.heap[0].upper > ctx->openBound)
+                    ctx->openBound = bf.heap[0].upper;
+                break;
+            }
+        }
+        knapsack_best_first_pop(&bf,&node);
+        ++result->expanded;
+        /* include the next item in a copy of the bitset; the excluding child
+           takes over the node's own slot */
+        if ((slot = knapsack_best_first_slot(&bf)) == SIZE_MAX) {
+            k_context_fail(ctx);
+            break;
+        }
+        path = bf.arena + slot*bf.words;
+        memcpy(path,bf.arena + node.path*bf.words,sizeof(uint64_t) * bf.words);
+        path[node.depth/64] |= (uint64_t)1 << node.depth%64;
+        child.cost = node.cost + set->cost[node.depth];
+        child.value = node.value + set->value[node.depth];
+        child.depth = node.depth + 1;
+        knapsack_best_first_child(&bf,&child,slot);
+        child.cost = node.cost;
+        child.value = node.value;
+        child.depth = k_context_next(ctx,node.depth);
+        knapsack_best_first_child(&bf,&child,node.path);
+    }
+    result->memory = (sizeof(struct k_bf_node) + sizeof(uint64_t)*bf.words + sizeof(size_t)) * bf.cap;
+    k_search_destroy(&bf.dfs);
+    free(bf.heap);
+    free(bf.arena);
+    free(bf.freeSlots);
+    k_bound_table_destroy(&bf.bound);
+}
+
+/* the dynamic programming solver keeps two rows of O(W) best values; the item
+   set is rebuilt by splitting the items in half, finding how the capacity is
+   divided between the halves in an optimal solution and recursing on each
+   half (Hirschberg's divide-and-conquer), so the n*W table is never stored */
+struct k_dynamic
+{
+    struct k_set items; /* the items that can fit */
+    int* forward; /* forward[c] is the best value of the left half with cost <= c */
+    int* backward; /* backward[c] is the same for the right half */
+    struct k_sack* sack;
+    int failed; /* set if an item could not be added to the sack */
+};
+static void knapsack_dynamic_row(const int* costs,const int* values,size_t cnt,int* row,int capacity)
+{
+    size_t i;
+    int c;
+    for (c = 0;c <= capacity;++c)
+        row[c] = 0;
+    for (i = 0;i < cnt;++i) {
+        int cost = costs[i], value = values[i];
+        for (c = capacity;c >= cost;--c)
+            if (row[c-cost]+value > row[c])
+                row[c] = row[c-cost] + value;
+    }
+}
+static void knapsack_dynamic_recursive(struct k_dynamic* dyn,size_t lo,size_t hi,int capacity)
+{
+    int c, split, best;
+    size_t mid;
+    if (hi-lo == 1) {
+        if (dyn->items.cost[lo]<=capacity && dyn->items.value[lo]>0
+            && !k_sack_add_item(dyn->sack,dyn->items.id[lo],dyn->items.cost[lo],dyn->items.value[lo]))
+            dyn->failed = 1;
+        return;
+    }
+    mid = lo + (hi-lo)/2;
+    knapsack_dynamic_row(dyn->items.cost+lo,dyn->items.value+lo,mid-lo,dyn->forward,capacity);
+    knapsack_dynamic_row(dyn->items.cost+mid,dyn->items.value+mid,hi-mid,dyn->backward,capacity);
+    split = 0;
+    best = -1;
+    for (c = 0;c <= capacity;++c) {
+        if (dyn->forward[c]+dyn->backward[capacity-c] > best) {
+            best = dyn->forward[c] + dyn->backward[capacity-c];
+            split = c;
+        }
+    }
+    if (best == 0)
+        /* nothing in this range is worth taking */
+        return;
+    knapsack_dynamic_recursive(dyn,lo,mid,split);
+    knapsack_dynamic_recursive(dyn,mid,hi,capacity-split);
+}
+/* in a subset-sum instance every item's value equals its cost, so the best
+   sack is the subset with the largest sum that fits and the table of values
+   reduces to a bitset of the sums some subset reaches: an item is added to
+   every sum at once by or-ing in the bitset shifted left by its cost, 64 sums
+   per word (256 with AVX2); each sum records the item that first reached it,
+   and since that item was added to a sum reached by earlier items only, the
+   subset is rebuilt by following the records down from the best sum */
+static inline void knapsack_subset_sum_word(uint64_t* bits,uint32_t* first,size_t w,uint64_t shifted,uint32_t item)
+{
+    uint64_t newly = shifted & ~bits[w];
+    bits[w] |= shifted;
+    while (newly != 0) {
+        first[w*64 + __builtin_ctzll(newly)] = item;
+        newly &= newly - 1;
+    }
+}
+static struct k_sack* knapsack_subset_sum(struct k_context* ctx,const struct k_set* items)
+{
+    size_t i, words, top, w;
+    int capacity = ctx->info.limit, sum;
+    long long total;
+    uint64_t lastMask;
+    uint64_t* bits;
+    uint32_t* first;
+    struct k_sack* sack;
+    words = (size_t)capacity/64 + 1;
+    bits = calloc(words,sizeof(uint64_t));
+    first = malloc(sizeof(uint32_t) * ((size_t)capacity+1));
+    if (bits==NULL || first==NULL) {
+        free(bits);
+        free(first);
+        return NULL;
+    }
+    ctx->result->subsetSum = 1;
+    ctx->result->memory = sizeof(uint64_t)*words + sizeof(uint32_t)*((size_t)capacity+1);
+    lastMask = capacity%64==63 ? ~(uint64_t)0 : ((uint64_t)1 << (capacity%64 + 1)) - 1;
+    bits[0] = 1;
+    total = 0;
+    for (i = 0;i<items->cnt && !((bits[words-1] >> capacity%64) & 1);++i) {
+        int cost = items->cost[i];
+        size_t q = (size_t)cost / 64;
+        unsigned r = cost % 64;
+        if (cost == 0)
+            continue;
+        /* no sum above the total of the items so far is reached yet, so only
+           the words up to it are shifted */
+        total += cost;
+        top = total<capacity ? (size_t)total/64 : words-1;
+        if (top < q)
+            continue;
+        /* from the top down, so that each word is shifted in before the
+           words it reads from are changed */
+        w = top;
+        {
+            uint64_t shifted = bits[w-q] << r;
+            if (r>0 && w>q)
+                shifted |= bits[w-q-1] >> (64-r);
+            if (w == words-1)
+                shifted &= lastMask;
+            knapsack_subset_sum_word(bits,first,w,shifted,(uint32_t)i);
+        }
+#ifdef __AVX2__
+        {
+            __m128i left = _mm_cvtsi32_si128((int)r), right = _mm_cvtsi32_si128(64-(int)r);
+            /* blocks of 4 words whose lowest source word has a word below it */
+            while (w >= q+5) {
+                __m256i hi, lo, old, shifted, newly;
+                w -= 4;
+                hi = _mm256_loadu_si256((const __m256i*)(bits+w-q));
+                lo = _mm256_loadu_si256((const __m256i*)(bits+w-q-1));
+                old = _mm256_loadu_si256((const __m256i*)(bits+w));
+                shifted = _mm256_or_si256(_mm256_sll_epi64(hi,left),_mm256_srl_epi64(lo,right));
+                newly = _mm256_andnot_si256(old,shifted);
+                _mm256_storeu_si256((__m256i*)(bits+w),_mm256_or_si256(old,shifted));
+                if ( !_mm256_testz_si256(newly,newly) ) {
+                    uint64_t lanes[4];
+                    int k;
+                    _mm256_storeu_si256((__m256i*)lanes,newly);
+                    for (k = 0;k < 4;++k)
+                        while (lanes[k] != 0) {
+                            first[(w+k)*64 + __builtin_ctzll(lanes[k])] = (uint32_t)i;
+                            lanes[k] &= lanes[k] - 1;
+                        }
+                }
+            }
+        }
+#endif
+        while (w > q) {
+            uint64_t shifted;
+            --w;
+            shifted = bits[w-q] << r;
+            if (r>0 && w>q)
+                shifted |= bits[w-q-1] >> (64-r);
+            knapsack_subset_sum_word(bits,first,w,shifted,(uint32_t)i);
+        }
+    }
+    /* the best sum and one subset that reaches it */
+    for (w = words;w-- > 1 && bits[w] == 0;)
+        ;
+    sum = (int)(w*64 + 63 - __builtin_clzll(bits[w]));
+    sack = k_sack_new();
+    while (sack!=NULL && sum>0) {
+        uint32_t item = first[sum];
+        if ( !k_sack_add_item(sack,items->id[item],items->cost[item],items->value[item]) ) {
+            k_sack_free(sack);
+            sack = NULL;
+            break;
+        }
+        sum -= items->cost[item];
+    }
+    free(bits);
+    free(first);
+    return sack;
+}
+void knapsack_dynamic(struct k_context* ctx,struct k_set* set)
+{
+    size_t i, same;
+    struct k_dynamic dyn;
+    if (ctx->info.limit < 0)
+        return;
+    /* items that could never fit are left out of the tables */
+    if ( !k_set_init(&dyn.items,set->cnt) ) {
+        k_context_fail(ctx);
+        return;
+    }
+    for (i = same = 0;i < set->cnt;++i)
+        if (set->cost[i]>=0 && set->cost[i]<=ctx->info.limit) {
+            k_set_add(&dyn.items,set->id[i],set->cost[i],set->value[i]);
+            same += set->cost[i] == set->value[i];
+        }
+    if (same==dyn.items.cnt && dyn.items.cnt<=UINT32_MAX) {
+        struct k_sack* sack = knapsack_subset_sum(ctx,&dyn.items);
+        if (sack != NULL)
+            k_solution_check_sack(ctx,ctx->solution,sack);
+        else
+            k_context_fail(ctx);
+        k_set_destroy(&dyn.items);
+        return;
+    }
+    /* a capacity whose rows cannot be allocated is an error, not a crash */
+    dyn.forward = malloc(sizeof(int) * ((size_t)ctx->info.limit+1));
+    dyn.backward = malloc(sizeof(int) * ((size_t)ctx->info.limit+1));
+    dyn.sack = k_sack_new();
+    dyn.failed = 0;
+    if (dyn.forward!=NULL && dyn.backward!=NULL && dyn.sack!=NULL && dyn.items.cnt>0)
+        knapsack_dynamic_recursive(&dyn,0,dyn.items.cnt,ctx->info.limit);
+    if (dyn.forward==NULL || dyn.backward==NULL || dyn.sack==NULL || dyn.failed) {
+        if (dyn.sack != NULL)
+            k_sack_free(dyn.sack);
+        k_context_fail(ctx);
+    }
+    else
+        k_solution_check_sack(ctx,ctx->solution,dyn.sack);
+    k_set_destroy(&dyn.items);
+    free(dyn.forward);
+    free(dyn.backward);
+}
+/* the FPTAS scales the values down by K = epsilon*L/n, L being a lower bound
+   on the optimum and n the number of items, rounds them down and solves the
+   scaled problem exactly with a DP over the scaled values that keeps the least
+   cost of reaching each of them; rounding loses less than K per item, so the
+   sack found is worth at least OPT - n*K >= (1-epsilon)*OPT; the rows end at
+   the scaled LP bound, which is within a small factor of L, so they have
+   O(n/epsilon) entries and the run time is near n^2/epsilon; as in the DP
+   over capacities, the item set is rebuilt by divide and conquer so that
+   only two rows are ever stored */
+struct k_fptas
+{
+    struct k_set items; /* the items of some value that can fit */
+    size_t* scaled; /* scaled value of each item */
+    size_t top; /* scaled values above this are not told apart */
+    unsigned* forward; /* forward[p] is the least cost of a subset of the left half worth at least p */
+    unsigned* backward; /* backward[p] is the same for the right half */
+    unsigned char* taken;
+};
+static size_t knapsack_fptas_row(const struct k_fptas* fp,size_t lo,size_t hi,unsigned* row,int capacity)
+{
+    /* fill row[0..top] for items lo..hi-1, where top is the scaled value of
+       all of them (at most fp->top), and return top; a cost above the
+       capacity is left as UINT_MAX */
+    size_t i, p, top = 0;
+    for (i = lo;i < hi;++i)
+        top += fp->scaled[i];
+    if (top > fp->top)
+        top = fp->top;
+    row[0] = 0;
+    for (p = 1;p <= top;++p)
+        row[p] = UINT_MAX;
+    for (i = lo;i < hi;++i) {
+        size_t v = fp->scaled[i];
+        unsigned cost = (unsigned)fp->items.cost[i];
+        if (v == 0)
+            continue;
+        for (p = top;p > 0;--p) {
+            unsigned from = row[p>v ? p-v : 0];
+            if (from!=UINT_MAX && from+cost<=(unsigned)capacity && from+cost<row[p])
+                row[p] = from + cost;
+        }
+    }
+    return top;
+}
+static void knapsack_fptas_recursive(struct k_fptas* fp,size_t lo,size_t hi,int capacity)
+{
+    size_t mid, top1, top2, p1, p2, best;
+    unsigned split;
+    if (hi-lo == 1) {
+        if (fp->items.cost[lo]<=capacity && fp->scaled[lo]>0)
+            fp->taken[lo] = 1;
+        return;
+    }
+    mid = lo + (hi-lo)/2;
+    top1 = knapsack_fptas_row(fp,lo,mid,fp->forward,capacity);
+    top2 = knapsack_fptas_row(fp,mid,hi,fp->backward,capacity);
+    /* both rows are nondecreasing, so the best split is found by walking the
+       right row down while the left one goes up */
+    best = 0;
+    split = 0;
+    p2 = top2;
+    for (p1 = 0;p1<=top1 && fp->forward[p1]!=UINT_MAX;++p1) {
+        while (p2>0 && (fp->backward[p2]==UINT_MAX || fp->forward[p1]+fp->backward[p2]>(unsigned)capacity))
+            --p2;
+        if (p1+p2 > best) {
+            best = p1 + p2;
+            split = fp->forward[p1];
+        }
+    }
+    if (best == 0)
+        return;
+    knapsack_fptas_recursive(fp,lo,mid,(int)split);
+    knapsack_fptas_recursive(fp,mid,hi,capacity-(int)split);
+}
+void knapsack_fptas(struct k_context* ctx,struct k_set* set)
+{
+    size_t i, best, total;
+    int room, maxValue;
+    long long lower, upper, value;
+    double scale, epsilon = ctx->opts->epsilon;
+    struct k_fptas fp;
+    struct k_sack* sack;
+    struct knapsack_result* result = ctx->result;
+    if (ctx->info.limit < 0)
+        return;
+    /* ratio order for filling the room left by the rounding */
+    if (!k_set_order(set,ctx->items,ctx->items->byRatio) || !k_set_init(&fp.items,set->cnt)) {
+        k_context_fail(ctx);
+        return;
+    }
+    maxValue = 0;
+    for (i = 0;i < set->cnt;++i)
+        if (set->cost[i]>=0 && set->cost[i]<=ctx->info.limit && set->value[i]>0) {
+            k_set_add(&fp.items,set->id[i],set->cost[i],set->value[i]);
+            if (set->value[i] > maxValue)
+                maxValue = set->value[i];
+        }
+    /* any item that fits is a lower bound, and so is the heuristic sack less
+       the fixed items; the optimum of the free items is at most the LP bound
+       less the fixed items */
+    lower = ctx->info.lowerValueBound>maxValue ? ctx->info.lowerValueBound : maxValue;
+    upper = (long long)ctx->info.upperValueBound - ctx->fixedValue;
+    scale = epsilon * lower / (fp.items.cnt>0 ? fp.items.cnt : 1);
+    if (scale < 1.0)
+        /* the values are integers, so the scaled problem is the problem */
+        scale = 1.0;
+    result->epsilon = epsilon;
+    result->scale = scale;
+    fp.scaled = malloc(sizeof(size_t) * (fp.items.cnt>0 ? fp.items.cnt : 1));
+    fp.taken = calloc(fp.items.cnt>0 ? fp.items.cnt : 1,1);
+    fp.forward = fp.backward = NULL;
+    sack = NULL;
+    if (fp.scaled==NULL || fp.taken==NULL)
+        goto fail;
+    total = 0;
+    for (i = 0;i < fp.items.cnt;++i) {
+        fp.scaled[i] = (size_t)floor(fp.items.value[i] / scale);
+        total += fp.scaled[i];
+    }
+    /* no subset is worth more than the bound, nor than all the items */
+    fp.top = (size_t)((upper>lower ? upper : lower) / scale) + 1;
+    if (fp.top > total)
+        fp.top = total;
+    fp.forward = malloc(sizeof(unsigned) * (fp.top+1));
+    fp.backward = malloc(sizeof(unsigned) * (fp.top+1));
+    if (fp.forward==NULL || fp.backward==NULL)
+        goto fail;
+    result->memory = 2 * sizeof(unsigned) * (fp.top+1);
+    if (fp.items.cnt > 0)
+        knapsack_fptas_recursive(&fp,0,fp.items.cnt,ctx->info.limit);
+    /* the scaled optimum, then whatever else still fits, by ratio */
+    if ((sack = k_sack_new()) == NULL)
+        goto fail;
+    best = 0;
+    for (i = 0;i < fp.items.cnt;++i)
+        if (fp.taken[i]) {
+            if ( !k_sack_add_item(sack,fp.items.id[i],fp.items.cost[i],fp.items.value[i]) )
+                goto fail;
+            best += fp.scaled[i];
+        }
+    room = ctx->info.limit - sack->cost;
+    for (i = 0;i < fp.items.cnt;++i)
+        if (!fp.taken[i] && fp.items.cost[i]<=room) {
+            if ( !k_sack_add_item(sack,fp.items.id[i],fp.items.cost[i],fp.items.value[i]) )
+                goto fail;
+            room -= fp.items.cost[i];
+        }
+    /* the optimum of the free items is below scale*(best+n) */
+    if (scale > 1.0) {
+        value = (long long)floor(scale * (best + fp.items.cnt));
+        ctx->openBound = value<INT_MAX ? (int)value : INT_MAX;
+    }
+    k_solution_check_sack(ctx,ctx->solution,sack);
+    goto done;
+fail:
+    if (sack != NULL)
+        k_sack_free(sack);
+    k_context_fail(ctx);
+done:
+    k_set_destroy(&fp.items);
+    free(fp.scaled);
+    free(fp.taken);
+    free(fp.forward);
+    free(fp.backward);
+}
+/* parametric mode: a single DP row over the capacities 0..W, W being the
+   largest queried limit, answers every query at once since row[c] ends up as
+   the best value for limit c; a decision table keeps one bit per item and
+   capacity recording whether adding the item improved row[c], which is enough
+   to walk back the items of any limit; if the table would be too large, the
+   items of each query are rebuilt with the divide-and-conquer solver instead */
+enum k_limits_constants
+{
+    K_LIMITS_MAX_TABLE = 1 << 30 /* bytes */
+};
+int knapsack_solve_limits(const struct knapsack_problem* problem,const int* limits,size_t cnt,struct knapsack_limits* out)
+{
+    size_t i, q, words;
+    int c, maxLimit;
+    int* row;
+    uint64_t* table;
+    double passCpu;
+    struct timespec start;
+    struct k_set set;
+    struct k_dynamic dyn;
+    const struct k_items* items = &problem->items;
+    memset(out,0,sizeof(struct knapsack_limits));
+    maxLimit = 0;
+    for (q = 0;q < cnt;++q)
+        if (limits[q] > maxLimit)
+            maxLimit = limits[q];
+    /* items that cannot fit any query or add no value are left out */
+    if ( !k_set_init(&set,items->cnt) )
+        return KNAPSACK_NO_MEMORY;
+    for (i = 0;i < items->cnt;++i)
+        if (items->cost[i]>=0 && items->cost[i]<=maxLimit && items->value[i]>0)
+            k_set_add(&set,i,items->cost[i],items->value[i]);
+    row = malloc(sizeof(int) * ((size_t)maxLimit+1));
+    out->results = calloc(cnt>0 ? cnt : 1,sizeof(struct knapsack_result));
+    dyn.forward = dyn.backward = NULL;
+    table = NULL;
+    if (row==NULL || out->results==NULL)
+        goto fail;
+    /* the table is optional, so failing to allocate it is not an error */
+    words = ((size_t)maxLimit + 64) / 64;
+    if (set.cnt>0 && words<=K_LIMITS_MAX_TABLE/sizeof(uint64_t)/set.cnt)
+        table = calloc(set.cnt*words,sizeof(uint64_t));
+    if (table == NULL) {
+        dyn.items = set;
+        dyn.forward = malloc(sizeof(int) * ((size_t)maxLimit+1));
+        dyn.backward = malloc(sizeof(int) * ((size_t)maxLimit+1));
+        dyn.failed = 0;
+        if (dyn.forward==NULL || dyn.backward==NULL)
+            goto fail;
+    }
+
+    passCpu = cpu_seconds();
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    for (c = 0;c <= maxLimit;++c)
+        row[c] = 0;
+    for (i = 0;i < set.cnt;++i) {
+        int cost = set.cost[i], value = set.value[i];
+        if (table != NULL) {
+            uint64_t* bits = table + i*words;
+            for (c = maxLimit;c >= cost;--c)
+                if (row[c-cost]+value > row[c]) {
+                    row[c] = row[c-cost] + value;
+                    bits[c>>6] |= (uint64_t)1 << (c&63);
+                }
+        }
+        else
+            for (c = maxLimit;c >= cost;--c)
+                if (row[c-cost]+value > row[c])
+                    row[c] = row[c-cost] + value;
+    }
+    out->passSeconds = elapsed_seconds(&start);
+    passCpu = cpu_seconds() - passCpu;
+    out->maxLimit = maxLimit;
+    out->itemCnt = set.cnt;
+    out->tableBytes = table!=NULL ? set.cnt*words*sizeof(uint64_t) : 0;
+
+    for (q = 0;q < cnt;++q) {
+        struct k_sack* sack;
+        struct knapsack_result* result = out->results + q;
+        double cpu = cpu_seconds();
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        if ((sack = k_sack_new()) == NULL)
+            goto fail;
+        /* a negative limit keeps the empty sack: nothing fits it, not even
+           an item of no cost */
+        if (limits[q]>=0 && table!=NULL) {
+            /* walk back from the last item; an item whose bit is set at the
+               remaining capacity was taken */
+            c = limits[q];
+            for (i = set.cnt;i-- > 0;)
+                if (table[i*words + (c>>6)] & ((uint64_t)1 << (c&63))) {
+                    if ( !k_sack_add_item(sack,set.id[i],set.cost[i],set.value[i]) ) {
+                        k_sack_free(sack);
+                        goto fail;
+                    }
+                    c -= set.cost[i];
+                }
+        }
+        else if (limits[q]>=0 && set.cnt>0) {
+            dyn.sack = sack;
+            knapsack_dynamic_recursive(&dyn,0,set.cnt,limits[q]);
+            if (dyn.failed) {
+                k_sack_free(sack);
+                goto fail;
+            }
+        }
+        result->algorithm = KNAPSACK_DP;
+        result->limit = limits[q];
+        result->optimal = 1;
+        result->upper = sack->value;
+        result->freeCnt = set.cnt;
+        result->wallSeconds = out->passSeconds + elapsed_seconds(&start);
+        result->cpuSeconds = passCpu + cpu_seconds() - cpu;
+        k_sack_release(sack,&result->sack);
+        out->cnt = q+1;
+    }
+    free(dyn.forward);
+    free(dyn.backward);
+    free(table);
+    free(row);
+    k_set_destroy(&set);
+    return 0;
+fail:
+    knapsack_limits_destroy(out);
+    free(dyn.forward);
+    free(dyn.backward);
+    free(table);
+    free(row);
+    k_set_destroy(&set);
+    return KNAPSACK_NO_MEMORY;
+}
+void knapsack_limits_destroy(struct knapsack_limits* out)
+{
+    size_t q;
+    for (q = 0;q < out->cnt;++q)
+        knapsack_result_destroy(out->results + q);
+    free(out->results);
+    out->results = NULL;
+    out->cnt = 0;
+}
+/* meet-in-the-middle (Horowitz-Sahni): the subsets of each half of the items
+   are enumerated into a list sorted by cost from which dominated subsets (cost
+   no lower but value no higher than another subset) are removed; the two
+   Pareto lists are then merged with a two-pointer sweep */
+struct k_subset
+{
+    int cost;
+    int value;
+    uint32_t mask; /* bit i is set if the i-th item of the half is included */
+};
+struct k_subset_list
+{
+    size_t sz, cap;
+    struct k_subset* subsets;
+};
+static size_t knapsack_meet_in_the_middle_list(const int* costs,const int* values,size_t cnt,int limit,struct k_subset_list* list)
+{
+    /* if memory runs out the list is left without subsets (NULL) */
+    size_t i, peak;
+    struct k_subset_list next;
+    list->sz = 1;
+    list->cap = 1;
+    list->subsets = malloc(sizeof(struct k_subset));
+    next.sz = next.cap = 0;
+    next.subsets = NULL;
+    if (list->subsets == NULL) {
+        list->sz = list->cap = 0;
+        return 0;
+    }
+    list->subsets[0].cost = list->subsets[0].value = 0;
+    list->subsets[0].mask = 0;
+    peak = 0;
+    for (i = 0;i < cnt;++i) {
+        size_t a, b;
+        int cost = costs[i], value = values[i];
+        if (next.cap < list->sz*2) {
+            struct k_subset* newblock;
+            newblock = realloc(next.subsets,sizeof(struct k_subset) * list->sz*2);
+            if (newblock == NULL) {
+                free(next.subsets);
+                free(list->subsets);
+                list->subsets = NULL;
+                list->sz = list->cap = 0;
+                return peak;
+            }
+            next.subsets = newblock;
+            next.cap = list->sz*2;
+        }
+        if ((list->cap+next.cap)*sizeof(struct k_subset) > peak)
+            peak = (list->cap+next.cap) * sizeof(struct k_subset);
+        /* merge the list with a copy of itself that includes item i; both are
+           sorted by cost so the result is too; keep only subsets that are
+           worth more than every cheaper subset */
+        next.sz = 0;
+        a = b = 0;
+        while (a<list->sz || b<list->sz) {
+            struct k_subset cand;
+            if (b>=list->sz || list->subsets[b].cost+cost>limit)
+                b = list->sz; /* the rest of the shifted list is over the limit */
+            if (b >= list->sz && a >= list->sz)
+                break;
+            if (b>=list->sz || (a<list->sz && (list->subsets[a].cost<list->subsets[b].cost+cost
+                        || (list->subsets[a].cost==list->subsets[b].cost+cost && list->subsets[a].value>=list->subsets[b].value+value))))
+                cand = list->subsets[a++];
+            else {
+                cand.cost = list->subsets[b].cost + cost;
+                cand.value = list->subsets[b].value + value;
+                cand.mask = list->subsets[b].mask | ((uint32_t)1 << i);
+                ++b;
+            }
+            if (next.sz==0 || cand.value>next.subsets[next.sz-1].value)
+                next.subsets[next.sz++] = cand;
+        }
+        /* swap lists */
+        {
+            struct k_subset_list tmp = *list;
+            *list = next;
+            next = tmp;
+        }
+    }
+    free(next.subsets);
+    return peak;
+}
+void knapsack_meet_in_the_middle(struct k_context* ctx,struct k_set* set)
+{
+    size_t cnt, half, i, j, peak[2];
+    int best;
+    uint32_t bestMask[2];
+    struct k_subset_list lists[2];
+    struct k_sack* sack;
+    /* knapsack_solve() turns down sets of more than KNAPSACK_MITM_MAX_ITEMS */
+    cnt = set->cnt;
+    if (ctx->info.limit < 0)
+        return;
+    half = cnt / 2;
+    peak[0] = knapsack_meet_in_the_middle_list(set->cost,set->value,half,ctx->info.limit,lists);
+    peak[1] = knapsack_meet_in_the_middle_list(set->cost+half,set->value+half,cnt-half,ctx->info.limit,lists+1);
+    sack = NULL;
+    if (lists[0].subsets==NULL || lists[1].subsets==NULL)
+        goto fail;
+    /* for each left subset in order of increasing cost, the best right subset
+       that still fits is the last one whose cost does not exceed what is left */
+    best = -1;
+    bestMask[0] = bestMask[1] = 0;
+    j = lists[1].sz;
+    for (i = 0;i < lists[0].sz;++i) {
+        struct k_subset* left = lists[0].subsets + i;
+        while (j>0 && left->cost+lists[1].subsets[j-1].cost>ctx->info.limit)
+            --j;
+        if (j == 0)
+            break;
+        if (left->value+lists[1].subsets[j-1].value > best) {
+            best = left->value + lists[1].subsets[j-1].value;
+            bestMask[0] = left->mask;
+            bestMask[1] = lists[1].subsets[j-1].mask;
+        }
+    }
+    ctx->result->paretoCnt[0] = lists[0].sz;
+    ctx->result->paretoCnt[1] = lists[1].sz;
+    ctx->result->memory = peak[0]>peak[1] ? peak[0] : peak[1];
+    if ((sack = k_sack_new()) == NULL)
+        goto fail;
+    for (i = 0;i < cnt;++i)
+        if (((i<half ? bestMask[0]>>i : bestMask[1]>>(i-half)) & 1)
+            && !k_sack_add_item(sack,set->id[i],set->cost[i],set->value[i]))
+            goto fail;
+    k_solution_check_sack(ctx,ctx->solution,sack);
+    goto done;
+fail:
+    if (sack != NULL)
+        k_sack_free(sack);
+    k_context_fail(ctx);
+done:
+    free(lists[0].subsets);
+    free(lists[1].subsets);
+}
+int knapsack_reduce(struct knapsack_problem* problem)
+{
+    /* Dembo-Hammer reduction: with lambda the value/cost ratio of the critical
+       item, lambda*W + sum(max(0,v_i - lambda*c_i)) bounds the value of any
+       feasible sack; forcing item j against its LP decision lowers that bound
+       by |v_j - lambda*c_j|; if the result falls below the greedy lower bound,
+       no optimal sack can contain that decision; the free items are left in
+       ratio order; the tests are made exactly, in integers, on the bounds
+       times the critical item's cost c_s, since a bound that equals the lower
+       bound may round either way in floating point; zero is returned if
+       memory runs out */
+    __extension__ typedef __int128 k_wide;
+    size_t i, s, cnt, fixedOut;
+    int leftover, critCost, critValue;
+    long long prefix;
+    k_wide upper, scaledLower;
+    struct timespec start;
+    const struct k_items* items = &problem->items;
+    const size_t* order = items->byRatio;
+    int limit = problem->limit, lower = problem->bounds.lower;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    cnt = items->cnt;
+    /* find the critical item and the LP bound */
+    leftover = limit;
+    prefix = 0;
+    for (s = 0;s < cnt;++s) {
+        if (items->cost[order[s]] > leftover)
+            break;
+        leftover -= items->cost[order[s]];
+        prefix += items->value[order[s]];
+    }
+    /* with every item in, lambda is 0 and c_s may be taken as 1 */
+    critCost = 1;
+    critValue = 0;
+    if (s < cnt) {
+        critCost = items->cost[order[s]];
+        critValue = items->value[order[s]];
+    }
+    upper = (k_wide)prefix*critCost + (k_wide)leftover*critValue;
+    scaledLower = (k_wide)lower * critCost;
+    fixedOut = 0;
+    for (i = 0;i < cnt;++i) {
+        size_t id = order[i];
+        int cost = items->cost[id], value = items->value[id];
+        k_wide reduced = (k_wide)value*critCost - (k_wide)critValue*cost;
+        if (cost > limit)
+            ++fixedOut;
+        else if (i<s && upper-reduced<scaledLower) {
+            if ( !k_sack_add_item(problem->fixed,id,cost,value) )
+                return 0;
+        }
+        else if (i>s && upper+reduced<scaledLower)
+            ++fixedOut;
+        else
+            k_set_add(&problem->freeItems,id,cost,value);
+    }
+    problem->bounds.fixedIn = problem->fixed->itemSz;
+    problem->bounds.fixedOut = fixedOut;
+    problem->bounds.freeCnt = problem->freeItems.cnt;
+    problem->bounds.reduceSeconds = elapsed_seconds(&start);
+    return 1;
+}
+struct k_sack* greedy(const struct k_items* items,const size_t* order,int limit,int stop)
+{
+    /* take the items in the given order while they fit; if 'stop' is set the
+       order is by increasing cost so nothing after the first misfit can fit */
+    size_t iter;
+    int leftover;
+    struct k_sack* sack;
+    if ((sack = k_sack_new()) == NULL)
+        return NULL;
+    leftover = limit;
+    for (iter = 0;iter < items->cnt;++iter) {
+        size_t id = order[iter];
+        if (items->cost[id] <= leftover) {
+            if ( !k_sack_add_item(sack,id,items->cost[id],items->value[id]) ) {
+                k_sack_free(sack);
+                return NULL;
+            }
+            leftover -= items->cost[id];
+        }
+        else if (stop)
+            break;
+    }
+    return sack;
+}
+struct k_partial_sack* partial_knapsack(const struct k_items* items,int limit)
+{
+    size_t iter;
+    int leftover;
+    struct k_partial_sack* sack;
+    if ((sack = k_partial_sack_new()) == NULL)
+        return NULL;
+    leftover = limit;
+    for (iter = 0;iter < items->cnt;++iter) {
+        size_t id = items->byRatio[iter];
+        int cost = items->cost[id] > leftover ? leftover : items->cost[id];
+        if ( !k_partial_sack_add_item(sack,items,id,cost) ) {
+            k_partial_sack_free(sack);
+            return NULL;
+        }
+        if ((leftover-=cost) <= 0)
+            break;
+    }
+    return sack;
+}
+
+/* Balas-Zemel: each round partitions the remaining items three ways around a
+   random pivot ratio; if the items of higher ratio do not fit, the critical
+   item is among them, otherwise they are taken whole along with the items of
+   the pivot's ratio that fit, and the search goes on among the lower ratios;
+   ratios are compared by cross-multiplying so that no division is needed */
+static inline long long k_ratio_compare(const int* cost,const int* value,size_t a,size_t b)
+{
+    return (long long)value[a]*cost[b] - (long long)value[b]*cost[a];
+}
+double knapsack_lp_bound(const int* cost,const int* value,size_t cnt,int limit,size_t* critical)
+{
+    size_t i, n, lo, hi, lt, gt, pivot, tmp;
+    size_t* idx;
+    long long room, highCost, highValue;
+    double bound;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    *critical = cnt;
+    idx = malloc(sizeof(size_t) * (cnt>0 ? cnt : 1));
+    if (idx == NULL)
+        return -1.0;
+    for (i = n = 0;i < cnt;++i)
+        if (value[i] > 0)
+            idx[n++] = i;
+    room = limit;
+    bound = 0.0;
+    lo = 0;
+    hi = n;
+    while (lo<hi && room>=0) {
+        state = state*6364136223846793005ULL + 1442695040888963407ULL;
+        pivot = idx[lo + (size_t)((state >> 33) % (hi-lo))];
+        /* [lo,lt) has a higher ratio than the pivot, [lt,gt) the same and
+           [gt,hi) a lower one */
+        lt = i = lo;
+        gt = hi;
+        while (i < gt) {
+            long long d = k_ratio_compare(cost,value,idx[i],pivot);
+            if (d > 0) {
+                tmp = idx[i];
+                idx[i++] = idx[lt];
+                idx[lt++] = tmp;
+            }
+            else if (d < 0) {
+                tmp = idx[i];
+                idx[i] = idx[--gt];
+                idx[gt] = tmp;
+            }
+            else
+                ++i;
+        }
+        highCost = highValue = 0;
+        for (i = lo;i < lt;++i) {
+            highCost += cost[idx[i]];
+            highValue += value[idx[i]];
+        }
+        if (highCost > room) {
+            hi = lt;
+            continue;
+        }
+        room -= highCost;
+        bound += highValue;
+        for (i = lt;i < gt;++i) {
+            size_t id = idx[i];
+            if (cost[id] > room) {
+                /* same formula as k_partial_sack_add_item() */
+                double part = value[id];
+                part *= (double)room / cost[id];
+                *critical = id;
+                free(idx);
+                return bound + part;
+            }
+            room -= cost[id];
+            bound += value[id];
+        }
+        lo = gt;
+    }
+    free(idx);
+    return bound;
+}
+
+/* local search: starting from a feasible sack, the best move of the first
+   kind that improves the value is made until none does; each pass rebuilds
+   best[k], the most valuable item out of the sack among the k+1 cheapest, so
+   that the best item fitting any room is found by binary search; 2-swaps and
+   drop-and-refill moves are limited to candidate lists of the in items of
+   lowest ratio and the out items of highest ratio, which is where a greedy
+   sack can be improved; a pass is O(n), so large problems get fewer of them */
+enum k_local_constants
+{
+    K_LOCAL_CANDIDATES = 16, /* in items and out items tried by the 2-swaps */
+    K_LOCAL_REFILL = 64, /* out items a refill may take */
+    K_LOCAL_MAX_PASSES = 256,
+    K_LOCAL_WORK = 1 << 26, /* items visited by all passes */
+    K_LOCAL_NONE = -1
+};
+struct k_local
+{
+    const struct k_items* items;
+    char* in; /* in[id] is non-zero if the item is in the sack */
+    int cost, value, limit;
+    ptrdiff_t* best; /* indexed like byCost; an item id or K_LOCAL_NONE */
+    size_t inCand[K_LOCAL_CANDIDATES], outCand[K_LOCAL_REFILL];
+    size_t inCnt, outCnt;
+};
+struct k_local_move
+{
+    int delta; /* value gained */
+    ptrdiff_t drop[2], add[2];
+};
+static ptrdiff_t k_local_fit(const struct k_local* ls,long long room)
+{
+    /* the most valuable item out of the sack that costs at most 'room' */
+    size_t lo = 0, hi = ls->items->cnt;
+    const struct k_items* items = ls->items;
+    while (lo < hi) {
+        size_t mid = lo + (hi-lo)/2;
+        if (items->cost[items->byCost[mid]] <= room)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    return lo>0 ? ls->best[lo-1] : K_LOCAL_NONE;
+}
+static void k_local_prepare(struct k_local* ls)
+{
+    size_t k;
+    ptrdiff_t cur = K_LOCAL_NONE;
+    const struct k_items* items = ls->items;
+    for (k = 0;k < items->cnt;++k) {
+        size_t id = items->byCost[k];
+        if (!ls->in[id] && (cur==K_LOCAL_NONE || items->value[id]>items->value[cur]))
+            cur = (ptrdiff_t)id;
+        ls->best[k] = cur;
+    }
+    ls->inCnt = ls->outCnt = 0;
+    for (k = items->cnt;k>0 && ls->inCnt<K_LOCAL_CANDIDATES;--k)
+        if (ls->in[items->byRatio[k-1]])
+            ls->inCand[ls->inCnt++] = items->byRatio[k-1];
+    for (k = 0;k<items->cnt && ls->outCnt<K_LOCAL_REFILL;++k)
+        if (!ls->in[items->byRatio[k]])
+            ls->outCand[ls->outCnt++] = items->byRatio[k];
+}
+static void k_local_consider(struct k_local_move* move,int delta,ptrdiff_t drop0,ptrdiff_t drop1,ptrdiff_t add0,ptrdiff_t add1)
+{
+    if (delta > move->delta) {
+        move->delta = delta;
+        move->drop[0] = drop0;
+        move->drop[1] = drop1;
+        move->add[0] = add0;
+        move->add[1] = add1;
+    }
+}
+static void k_local_toggle(struct k_local* ls,ptrdiff_t id,int add)
+{
+    if (id == K_LOCAL_NONE)
+        return;
+    ls->in[id] = add;
+    ls->cost += add ? ls->items->cost[id] : -ls->items->cost[id];
+    ls->value += add ? ls->items->value[id] : -ls->items->value[id];
+}
+static int k_local_refill(struct k_local* ls,size_t drop,long long room,int take)
+{
+    /* fill 'room' with the out candidates in ratio order; 'drop' has just
+       been taken out and is not put back; the items are put in the sack if
+       'take' is set */
+    size_t k;
+    int gain = 0;
+    const struct k_items* items = ls->items;
+    for (k = 0;k < ls->outCnt;++k) {
+        size_t id = ls->outCand[k];
+        if (!ls->in[id] && id!=drop && items->cost[id]<=room) {
+            room -= items->cost[id];
+            gain += items->value[id];
+            if (take)
+                k_local_toggle(ls,(ptrdiff_t)id,1);
+        }
+    }
+    return gain;
+}
+static int k_local_pass(struct k_local* ls)
+{
+    /* find and make the best move of the first kind that improves the sack */
+    size_t i, k, p, a, b, x, y, pairCnt;
+    ptrdiff_t j;
+    long long room;
+    struct k_local_move move;
+    const struct k_items* items = ls->items;
+    k_local_prepare(ls);
+    room = (long long)ls->limit - ls->cost;
+    move.delta = 0;
+    /* add */
+    if ((j = k_local_fit(ls,room)) != K_LOCAL_NONE)
+        k_local_consider(&move,items->value[j],K_LOCAL_NONE,K_LOCAL_NONE,j,K_LOCAL_NONE);
+    /* 1-swap: any item in for the best item that fits in its place; the in
+       items are visited by increasing cost so the fit only moves forward */
+    if (move.delta == 0)
+        for (k = p = 0;k < items->cnt;++k) {
+            i = items->byCost[k];
+            if ( !ls->in[i] )
+                continue;
+            while (p<items->cnt && items->cost[items->byCost[p]]<=room+items->cost[i])
+                ++p;
+            if (p>0 && (j = ls->best[p-1]) != K_LOCAL_NONE)
+                k_local_consider(&move,items->value[j]-items->value[i],(ptrdiff_t)i,K_LOCAL_NONE,j,K_LOCAL_NONE);
+        }
+    /* drop and refill */
+    if (move.delta == 0)
+        for (a = 0;a < ls->inCnt;++a) {
+            size_t id = ls->inCand[a];
+            k_local_consider(&move,k_local_refill(ls,id,room + items->cost[id],0)-items->value[id],(ptrdiff_t)id,K_LOCAL_NONE,K_LOCAL_NONE,K_LOCAL_NONE);
+        }
+    /* 2-swap: one or two candidates in for one or two items out */
+    pairCnt = ls->outCnt<K_LOCAL_CANDIDATES ? ls->outCnt : K_LOCAL_CANDIDATES;
+    if (move.delta == 0)
+        for (a = 0;a < ls->inCnt;++a)
+            for (b = a;b < ls->inCnt;++b) {
+                /* b == a drops a single item */
+                ptrdiff_t d0 = ls->inCand[a], d1 = b>a ? (ptrdiff_t)ls->inCand[b] : K_LOCAL_NONE;
+                long long space = room + items->cost[d0] + (d1!=K_LOCAL_NONE ? items->cost[d1] : 0);
+                int lost = items->value[d0] + (d1!=K_LOCAL_NONE ? items->value[d1] : 0);
+                if (d1!=K_LOCAL_NONE && (j = k_local_fit(ls,space)) != K_LOCAL_NONE)
+                    k_local_consider(&move,items->value[j]-lost,d0,d1,j,K_LOCAL_NONE);
+                for (x = 0;x < pairCnt;++x)
+                    for (y = x+1;y < pairCnt;++y) {
+                        size_t o0 = ls->outCand[x], o1 = ls->outCand[y];
+                        if ((long long)items->cost[o0] + items->cost[o1] <= space)
+                            k_local_consider(&move,items->value[o0]+items->value[o1]-lost,d0,d1,(ptrdiff_t)o0,(ptrdiff_t)o1);
+                    }
+            }
+    if (move.delta <= 0)
+        return 0;
+    k_local_toggle(ls,move.drop[0],0);
+    k_local_toggle(ls,move.drop[1],0);
+    if (move.add[0]==K_LOCAL_NONE && move.drop[1]==K_LOCAL_NONE)
+        /* drop and refill */
+        k_local_refill(ls,(size_t)move.drop[0],(long long)ls->limit - ls->cost,1);
+    k_local_toggle(ls,move.add[0],1);
+    k_local_toggle(ls,move.add[1],1);
+    return 1;
+}
+struct k_sack* local_search(const struct k_items* items,const struct knapsack_sack* start,int limit,size_t* moves)
+{
+    size_t i, passes;
+    struct k_sack* sack;
+    struct k_local ls;
+    passes = K_LOCAL_WORK / (items->cnt>0 ? items->cnt : 1);
+    passes = passes<1 ? 1 : passes>K_LOCAL_MAX_PASSES ? K_LOCAL_MAX_PASSES : passes;
+    ls.items = items;
+    ls.limit = limit;
+    ls.in = calloc(items->cnt>0 ? items->cnt : 1,1);
+    ls.best = malloc(sizeof(ptrdiff_t) * (items->cnt>0 ? items->cnt : 1));
+    if (ls.in==NULL || ls.best==NULL) {
+        free(ls.in);
+        free(ls.best);
+        return NULL;
+    }
+    ls.cost = start->cost;
+    ls.value = start->value;
+    for (i = 0;i < start->cnt;++i)
+        ls.in[start->items[i]] = 1;
+    *moves = 0;
+    while (*moves<passes && k_local_pass(&ls))
+        ++*moves;
+    sack = k_sack_new();
+    for (i = 0;sack!=NULL && i<items->cnt;++i)
+        if (ls.in[i] && !k_sack_add_item(sack,i,items->cost[i],items->value[i])) {
+            k_sack_free(sack);
+            sack = NULL;
+        }
+    free(ls.in);
+    free(ls.best);
+    return sack;
+}
+
+/* public interface */
+void knapsack_options_init(struct knapsack_options* opts)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    opts->reduce = 1;
+    opts->localSearch = 1;
+    opts->order = KNAPSACK_ORDER_RATIO;
+    opts->collapse = 1;
+    opts->threads = cpus>0 ? (int)cpus : 1;
+    opts->splitDepth = 0;
+    opts->queueMemory = (size_t)256 << 20;
+    opts->epsilon = 0.1;
+    opts->timeLimit = 0.0;
+    opts->incumbent = NULL;
+    opts->arg = NULL;
+}
+const char* knapsack_algorithm_name(int algorithm)
+{
+    if (algorithm<0 || algorithm>=KNAPSACK_ALGORITHM_COUNT)
+        return NULL;
+    return algorithms[algorithm].name;
+}
+const char* knapsack_algorithm_title(int algorithm)
+{
+    if (algorithm<0 || algorithm>=KNAPSACK_ALGORITHM_COUNT)
+        return NULL;
+    return algorithms[algorithm].title;
+}
+int knapsack_algorithm_find(const char* name)
+{
+    int i;
+    for (i = 0;i < KNAPSACK_ALGORITHM_COUNT;++i)
+        if (strcmp(algorithms[i].name,name) == 0)
+            return i;
+    return -1;
+}
+struct knapsack_problem* knapsack_problem_new(const int* cost,const int* value,size_t cnt,int limit,const struct knapsack_options* opts)
+{
+    int i;
+    size_t j;
+    struct k_sack* sack;
+    struct k_partial_sack* partial;
+    struct knapsack_problem* problem;
+    static const int stops[KNAPSACK_GREEDY_COUNT] = {0, 1, 0};
+    /* the bounds, the reduction and the tables all take costs and values to
+       be at least zero */
+    for (j = 0;j < cnt;++j)
+        if (cost[j]<0 || value[j]<0)
+            return NULL;
+    problem = calloc(1,sizeof(struct knapsack_problem));
+    if (problem == NULL)
+        return NULL;
+    problem->limit = limit;
+    if (opts != NULL)
+        problem->opts = *opts;
+    else
+        knapsack_options_init(&problem->opts);
+    if ( !k_items_init(&problem->items,cost,value,cnt) ) {
+        free(problem);
+        return NULL;
+    }
+    /* the greedy sacks give the lower bound; the first of the best ones is
+       kept in case a search is stopped by the time limit */
+    problem->heuristic = NULL;
+    for (i = 0;i < KNAPSACK_GREEDY_COUNT;++i) {
+        const size_t* order = i==KNAPSACK_GREEDY_VALUE ? problem->items.byValue
+            : i==KNAPSACK_GREEDY_COST ? problem->items.byCost : problem->items.byRatio;
+        if ((sack = greedy(&problem->items,order,limit,stops[i])) == NULL)
+            goto fail;
+        k_sack_release(sack,problem->bounds.greedy+i);
+        if (problem->bounds.greedy[i].value > problem->bounds.lower) {
+            problem->bounds.lower = problem->bounds.greedy[i].value;
+            problem->heuristic = problem->bounds.greedy + i;
+        }
+    }
+    problem->bounds.greedyLower = problem->bounds.lower;
+    if (problem->opts.localSearch && limit>=0) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        sack = local_search(&problem->items,problem->heuristic!=NULL ? problem->heuristic : problem->bounds.greedy,
+                limit,&problem->bounds.localMoves);
+        if (sack == NULL)
+            goto fail;
+        k_sack_release(sack,&problem->bounds.local);
+        problem->bounds.localSeconds = elapsed_seconds(&start);
+        if (problem->bounds.local.value > problem->bounds.lower) {
+            problem->bounds.lower = problem->bounds.local.value;
+            problem->heuristic = &problem->bounds.local;
+        }
+    }
+    /* the partial knapsack gives the upper bound */
+    if ((partial = partial_knapsack(&problem->items,limit)) == NULL)
+        goto fail;
+    problem->bounds.partialCost = partial->cost;
+    problem->bounds.partialValue = partial->value;
+    problem->bounds.partialCnt = partial->itemSz[0];
+    problem->bounds.partCnt = partial->itemSz[1];
+    problem->bounds.partialItems = partial->items[0];
+    problem->bounds.partItems = partial->items[1];
+    problem->bounds.upper = (int)floor(partial->value + 1e-9);
+    free(partial); /* its item lists now belong to the bounds */
+    /* fix the items that the bounds prove must be in or out of every optimal
+       sack; the exact algorithms only search the remaining items within the
+       capacity left over by the items fixed in */
+    if ((problem->fixed = k_sack_new())==NULL || !k_set_init(&problem->freeItems,cnt))
+        goto fail;
+    if (problem->opts.reduce) {
+        if ( !knapsack_reduce(problem) )
+            goto fail;
+    }
+    else {
+        for (j = 0;j < cnt;++j) {
+            size_t id = problem->items.byRatio[j];
+            k_set_add(&problem->freeItems,id,cost[id],value[id]);
+        }
+        problem->bounds.freeCnt = cnt;
+    }
+    /* identical items are next to each other in ratio order */
+    for (j = 0;j < problem->freeItems.cnt;++j)
+        if (j==0 || problem->freeItems.cost[j]!=problem->freeItems.cost[j-1] || problem->freeItems.value[j]!=problem->freeItems.value[j-1])
+            ++problem->bounds.classCnt;
+    return problem;
+fail:
+    knapsack_problem_free(problem);
+    return NULL;
+}
+void knapsack_problem_free(struct knapsack_problem* problem)
+{
+    int i;
+    for (i = 0;i < KNAPSACK_GREEDY_COUNT;++i)
+        free(problem->bounds.greedy[i].items);
+    free(problem->bounds.local.items);
+    free(problem->bounds.partialItems);
+    free(problem->bounds.partItems);
+    if (problem->fixed != NULL)
+        k_sack_free(problem->fixed);
+    k_set_destroy(&problem->freeItems);
+    k_items_destroy(&problem->items);
+    free(problem);
+}
+const struct knapsack_bounds* knapsack_problem_bounds(const struct knapsack_problem* problem)
+{
+    return &problem->bounds;
+}
+int knapsack_solve(const struct knapsack_problem* problem,int algorithm,struct knapsack_result* result)
+{
+    size_t i;
+    int fellBack;
+    double cpu;
+    struct k_set set;
+    struct k_context ctx;
+    struct k_solution* sol;
+    const struct k_sack* fixed = problem->fixed;
+    memset(result,0,sizeof(struct knapsack_result));
+    result->algorithm = algorithm;
+    result->limit = problem->limit;
+    result->freeCnt = problem->freeItems.cnt;
+    if (algorithm<0 || algorithm>=KNAPSACK_ALGORITHM_COUNT
+        || (algorithm==KNAPSACK_MITM && problem->freeItems.cnt>KNAPSACK_MITM_MAX_ITEMS))
+        return KNAPSACK_UNSUPPORTED;
+    /* each algorithm starts from the greedy lower bound so that they can be
+       compared fairly; the search may reorder its copy of the free items */
+    ctx.items = &problem->items;
+    ctx.opts = &problem->opts;
+    k_info_init(&ctx.info);
+    ctx.info.limit = problem->limit - fixed->cost;
+    ctx.info.lowerValueBound = problem->bounds.lower - fixed->value;
+    ctx.info.upperValueBound = problem->bounds.upper;
+    ctx.solution = sol = k_solution_new();
+    ctx.result = result;
+    ctx.fixedValue = fixed->value;
+    ctx.timedOut = 0;
+    ctx.openBound = INT_MIN;
+    ctx.failed = 0;
+    ctx.classEnd = NULL;
+    if (sol == NULL)
+        return KNAPSACK_NO_MEMORY;
+    if ( !k_set_init(&set,problem->freeItems.cnt) ) {
+        k_solution_free(sol);
+        return KNAPSACK_NO_MEMORY;
+    }
+    for (i = 0;i < problem->freeItems.cnt;++i)
+        k_set_add(&set,problem->freeItems.id[i],problem->freeItems.cost[i],problem->freeItems.value[i]);
+    /* the free items are kept by ratio; the other orders are taken from the
+       permutations built with the problem */
+    if (problem->opts.order == KNAPSACK_ORDER_VALUE)
+        ctx.failed = !k_set_order(&set,&problem->items,problem->items.byValue);
+    else if (problem->opts.order == KNAPSACK_ORDER_COST)
+        ctx.failed = !k_set_order(&set,&problem->items,problem->items.byCost);
+    else if (problem->opts.order == KNAPSACK_ORDER_INPUT)
+        ctx.failed = !k_set_order(&set,&problem->items,NULL);
+    cpu = cpu_seconds();
+    clock_gettime(CLOCK_MONOTONIC,&ctx.start);
+    if ( !ctx.failed )
+        algorithms[algorithm].solve(&ctx,&set);
+    result->wallSeconds = elapsed_seconds(&ctx.start);
+    result->cpuSeconds = cpu_seconds() - cpu + sol->cpuSeconds;
+    k_set_destroy(&set);
+    free(ctx.classEnd);
+    if (sol->sack != NULL)
+        for (i = 0;i<fixed->itemSz && !ctx.failed;++i) {
+            size_t id = fixed->items[i];
+            ctx.failed = !k_sack_add_item(sol->sack,id,problem->items.cost[id],problem->items.value[id]);
+        }
+    fellBack = 0;
+    if (!ctx.failed && problem->heuristic!=NULL && (sol->sack==NULL || sol->sack->value<problem->bounds.lower)) {
+        /* the search was stopped before it got past the heuristic sack, or
+           the FPTAS rounded its way below it; a completed exact search never
+           ends below it, so if one does nothing about it is proven */
+        const struct knapsack_sack* best = problem->heuristic;
+        fellBack = 1;
+        if (sol->sack != NULL)
+            k_sack_free(sol->sack);
+        sol->sack = k_sack_new();
+        ctx.failed = sol->sack == NULL;
+        for (i = 0;i<best->cnt && !ctx.failed;++i)
+            ctx.failed = !k_sack_add_item(sol->sack,best->items[i],problem->items.cost[best->items[i]],problem->items.value[best->items[i]]);
+    }
+    if (ctx.failed) {
+        /* whatever was found is not trusted; the result is left empty */
+        k_solution_free(sol);
+        knapsack_result_destroy(result);
+        memset(result,0,sizeof(struct knapsack_result));
+        result->algorithm = algorithm;
+        result->limit = problem->limit;
+        result->freeCnt = problem->freeItems.cnt;
+        return KNAPSACK_NO_MEMORY;
+    }
+    result->leaves = sol->sackCounter;
+    result->nodes = sol->nodeCounter;
+    result->costPrunes = sol->costPrunes;
+    result->boundPrunes = sol->boundPrunes;
+    k_sack_release(sol->sack,&result->sack);
+    sol->sack = NULL;
+    k_solution_free(sol);
+    /* a search that ran to completion has proven its sack optimal; otherwise
+       the best bound left in the abandoned subtrees limits how much better an
+       optimal sack could be */
+    if (ctx.openBound != INT_MIN)
+        result->upper = ctx.openBound + ctx.fixedValue;
+    else
+        result->upper = fellBack ? problem->bounds.upper : result->sack.value;
+    if (result->upper < result->sack.value)
+        result->upper = result->sack.value;
+    if (result->upper > problem->bounds.upper)
+        result->upper = problem->bounds.upper;
+    /* the FPTAS leaves its bound in openBound when it had to round, and its
+       sack is then only known to be optimal if it meets the bound */
+    result->optimal = !ctx.timedOut && result->upper==result->sack.value;
+    return 0;
+}
+void knapsack_result_destroy(struct knapsack_result* result)
+{
+    free(result->sack.items);
+    free(result->threadStats);
+    result->sack.items = NULL;
+    result->threadStats = NULL;
+}